@@ -0,0 +1,101 @@
+// everything a node needs to know about who attacks what
+// the evaluator, SEE and the legality check used to each work this out on their own,
+// now the search computes it once per node (see Searcher2::attackInfoAt) and hands it around
+
+#include "chess.hpp"
+#include "feature_extractor.hpp"
+#pragma once
+
+using namespace chess;
+
+struct AttackInfo {
+    // raw attack sets by color and piece type (pawn to king), computed on the full board occupancy
+    // so they include squares of both sides, the evaluator applies its own masks on top
+    Bitboard attacks[2][6]{};
+    Bitboard all[2]{}; // everything a color attacks
+
+    // for the side to move
+    Bitboard pinned = 0; // pieces pinned to their own king
+    Bitboard checkers = 0; // enemy pieces giving check
+    Bitboard kingDanger = 0; // squares the king can't step to (enemy attacks seen through the king)
+
+    Bitboard kingZone[2]{}; // calculateKingsZone for each king
+
+    U64 key = 0; // hash of the position this was computed for
+
+    void compute(const Board& board) {
+        const Bitboard occ = board.occ();
+
+        for (Color c : {Color::WHITE, Color::BLACK}) {
+            const int ci = static_cast<int>(c);
+            const Bitboard pawns = board.pieces(PieceType::PAWN, c);
+            attacks[ci][0] = c == Color::WHITE
+                ? attacks::pawnLeftAttacks<Color::WHITE>(pawns) | attacks::pawnRightAttacks<Color::WHITE>(pawns)
+                : attacks::pawnLeftAttacks<Color::BLACK>(pawns) | attacks::pawnRightAttacks<Color::BLACK>(pawns);
+
+            Bitboard bb = board.pieces(PieceType::KNIGHT, c);
+            attacks[ci][1] = 0;
+            while (bb) {
+                attacks[ci][1] |= attacks::knight(builtin::poplsb(bb));
+            }
+            bb = board.pieces(PieceType::BISHOP, c);
+            attacks[ci][2] = 0;
+            while (bb) {
+                attacks[ci][2] |= attacks::bishop(builtin::poplsb(bb), occ);
+            }
+            bb = board.pieces(PieceType::ROOK, c);
+            attacks[ci][3] = 0;
+            while (bb) {
+                attacks[ci][3] |= attacks::rook(builtin::poplsb(bb), occ);
+            }
+            bb = board.pieces(PieceType::QUEEN, c);
+            attacks[ci][4] = 0;
+            while (bb) {
+                attacks[ci][4] |= attacks::queen(builtin::poplsb(bb), occ);
+            }
+
+            const Bitboard king = board.pieces(PieceType::KING, c);
+            attacks[ci][5] = king ? attacks::king(builtin::lsb(king)) : 0;
+            kingZone[ci] = calculateKingsZone(king, c);
+
+            all[ci] = attacks[ci][0] | attacks[ci][1] | attacks[ci][2] | attacks[ci][3] | attacks[ci][4] | attacks[ci][5];
+        }
+
+        const Color us = board.sideToMove();
+        const Square kingSq = board.kingSq(us);
+        pinned = movegen::pinnedPieces(board, us);
+        checkers = attacks::attackers(board, ~us, kingSq, occ);
+
+        // only a slider giving check can see through the king to the square behind it
+        kingDanger = all[static_cast<int>(~us)];
+        const Bitboard occXKing = occ ^ (1ULL << kingSq);
+        const Bitboard queens = board.pieces(PieceType::QUEEN, ~us);
+        Bitboard sliders = checkers & (board.pieces(PieceType::BISHOP, ~us) | queens);
+        while (sliders) {
+            kingDanger |= attacks::bishop(builtin::poplsb(sliders), occXKing);
+        }
+        sliders = checkers & (board.pieces(PieceType::ROOK, ~us) | queens);
+        while (sliders) {
+            kingDanger |= attacks::rook(builtin::poplsb(sliders), occXKing);
+        }
+
+        key = board.hash();
+    }
+
+    bool inCheck() const {
+        return checkers != 0;
+    }
+
+    Bitboard sliderAttacks(Color c) const {
+        const int ci = static_cast<int>(c);
+        return attacks[ci][2] | attacks[ci][3] | attacks[ci][4];
+    }
+
+    // movegen::isLegal for a pseudo legal move, king moves are answered from kingDanger
+    bool isLegal(const Board& board, const Move& move) const {
+        if (move.typeOf() == Move::NORMAL && move.from() == board.kingSq(board.sideToMove())) {
+            return !(kingDanger & (1ULL << move.to()));
+        }
+        return movegen::isLegal(board, move, pinned, inCheck());
+    }
+};
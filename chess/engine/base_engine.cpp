@@ -21,6 +21,7 @@ chess::Board board;
 unique_ptr<Searcher2> searcher; 
 mutex searchThreadMutex;
 unique_ptr<std::thread> searchThread;
+size_t hashMegabytes = 256; // transposition table size, set with the Hash option
 
 
 void setPosition(const std::string& uci, const std::vector<std::string>& tokens) {
@@ -45,12 +46,29 @@ void setPosition(const std::string& uci, const std::vector<std::string>& tokens)
         board.makeMove(chess::uci::uciToMove(board, tokens[i]));
 }
 
+// the searcher owns the transposition table, which takes a while to allocate,
+// so it is made on the first isready/go instead of before we can answer uci
+void ensureSearcher() {
+    if (!searcher) {
+        try {
+            searcher = make_unique<Searcher2>(board, resultX2, ga1result10, TranspositionTable::entriesForMegabytes(hashMegabytes));
+        }
+        catch (const std::bad_alloc&) {
+            cout << "info string could not allocate " << hashMegabytes << " MB of hash, using 16 MB" << endl;
+            hashMegabytes = 16;
+            searcher = make_unique<Searcher2>(board, resultX2, ga1result10, TranspositionTable::entriesForMegabytes(hashMegabytes));
+        }
+    }
+}
+
 void startSearch(int timeLeft, int timeIncrement, int movesToGo) {
+    ensureSearcher();
     if (searcher) {
         lock_guard<mutex> guard(searchThreadMutex);
         if (searchThread && searchThread->joinable()) {
             searchThread->join(); // Ensure the previous search is finished
         }
+        searcher->resetStop(); // here and not in the search thread, so a stop right after go isn't lost
 
         // Create a new thread for the search operation
         // Capture time control parameters by value in the lambda
@@ -64,11 +82,55 @@ void startSearch(int timeLeft, int timeIncrement, int movesToGo) {
 
 void stopSearch() {
     lock_guard<mutex> guard(searchThreadMutex);
+    if (searcher) {
+        searcher->stop(); // the search notices this on its next node
+    }
     if (searchThread && searchThread->joinable()) {
         searchThread->join(); // Wait for the search to finish
     }
 }
 
+// setoption name <name> value <value>
+void setOption(const std::vector<std::string>& tokens) {
+    if (tokens.size() < 5 || tokens[1] != "name" || tokens[3] != "value") {
+        return;
+    }
+    if (tokens[2] == "SyzygyPath") {
+        string path = tokens[4];
+        for (size_t i = 5; i < tokens.size(); i++) {
+            path += " " + tokens[i]; // paths can have spaces in them
+        }
+        stopSearch();
+        if (syzygy::init(path)) {
+            cout << "info string found " << syzygy::largest() << " piece syzygy tablebases" << endl;
+        }
+        else if (!path.empty() && path != "<empty>") {
+            cout << "info string no syzygy tablebases loaded from " << path << endl;
+        }
+    }
+    if (tokens[2] == "Hash") {
+        long megabytes;
+        try {
+            megabytes = std::stol(tokens[4]);
+        }
+        catch (const std::exception&) {
+            return; // not a number, keep the old size
+        }
+        const size_t oldMegabytes = hashMegabytes;
+        hashMegabytes = static_cast<size_t>(std::min(std::max(megabytes, 1l), 65536l));
+        stopSearch();
+        if (searcher) {
+            try {
+                searcher->setHashSize(hashMegabytes);
+            }
+            catch (const std::bad_alloc&) {
+                cout << "info string could not allocate " << hashMegabytes << " MB of hash, keeping " << oldMegabytes << " MB" << endl;
+                hashMegabytes = oldMegabytes;
+            }
+        }
+    }
+}
+
 // Splits strings into words seperated by delimiter, stolen from 
 //https://github.com/Orbital-Web/Raphael/blob/main/uci.cpp#L23
 vector<string> splitstr(const std::string& str, const char delim) {
@@ -83,7 +145,6 @@ vector<string> splitstr(const std::string& str, const char delim) {
 }
 
 int main() {
-    searcher = make_unique<Searcher2>(board, resultX2, ga1result10); // Use fully qualified name
     string uci;
     bool quit = false;
     bool isWhiteTurn = board.sideToMove() == Color::WHITE;
@@ -98,13 +159,15 @@ while (!quit) {
     if (keyword == "uci") {
         cout << "id name Gerald Current" << endl;
         cout << "id author Elliot Harris" << endl;
-        // Output other UCI options here, if any
+        cout << "option name Hash type spin default 256 min 1 max 65536" << endl;
+        cout << "option name SyzygyPath type string default <empty>" << endl;
         cout << "uciok" << endl;
     } 
-    // else if (keyword == "setoption") { // don't have a setoption 
-    //     // handle setoption command
-    // }
+    else if (keyword == "setoption") {
+        setOption(tokens);
+    }
     else if (keyword == "isready") {
+        ensureSearcher();
         cout << "readyok" << endl;
     } 
     else if (keyword == "position") {
@@ -141,7 +204,11 @@ while (!quit) {
     // Start the search with time management
     startSearch(timeLeft, timeIncrement, movesToGo);
     }
+    else if (keyword == "stop") {
+        stopSearch();
+    }
     else if (keyword == "quit") {
+        stopSearch();
         quit = true;
     }
 }
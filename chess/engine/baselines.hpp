@@ -79,6 +79,19 @@ struct TunableSearch{
     // for null move pruning
     int nullMovePruningInitialReduction = 0;
     int nullMovePruningDepthFactor = 0;
+
+    // for internal iterative reductions (0 turns it off)
+    // defaults are here so older tuned results still get a sensible value
+    int iirDepth = 4;
+
+    // for internal iterative deepening at pv nodes (0 turns it off)
+    int iidDepth = 5;
+    int iidReduction = 2;
+
+    // for probcut (0 depth turns it off)
+    int probCutMargin = 150;
+    int probCutDepth = 5;
+    int probCutReduction = 4;
 };
 
 // Global instance
@@ -134,7 +147,13 @@ TunableSearch baseSearch = {
         3, // initial move count for late move reductions
         10, // late move pruning move count
         2, // null move pruning initial reduction
-        10 // null move pruning depth factor
+        10, // null move pruning depth factor
+        4, // internal iterative reduction depth
+        5, // internal iterative deepening depth
+        2, // internal iterative deepening reduction
+        150, // probcut margin
+        5, // probcut depth
+        4 // probcut reduction
     };
 
 TunableEval zeroEval = {
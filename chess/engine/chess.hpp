@@ -48,6 +48,13 @@ VERSION: 0.5.13
 #include <utility>
 #include <vector>
 
+// Slider lookups use PEXT when the target has BMI2, and magic multiplication otherwise.
+// Define CHESS_NO_PEXT to force magics, e.g. on CPUs where pext is microcoded (AMD before Zen 3).
+#if defined(__BMI2__) && !defined(CHESS_NO_PEXT)
+#define CHESS_USE_PEXT
+#include <immintrin.h>
+#endif
+
 namespace chess {
 
 /****************************************************************************\
@@ -951,39 +958,47 @@ void legalmoves(Movelist &movelist, const Board &board,
 }  // namespace movegen
 
 /****************************************************************************\
- * attacks Forward Declaration                                               *
+ * Slider attack tables                                                      *
 \****************************************************************************/
 
-class attacks {
-    struct Magic {
-        Bitboard mask;
-        U64 magic;
-        U64 *attacks;
-        U64 shift;
+namespace slider_tables {
 
-        U64 operator()(U64 b) const { return ((b & mask) * magic) >> shift; }
-    };
+/// @brief [Internal Usage] Where one square's slider attacks live in the attack table
+struct Magic {
+    Bitboard mask;
+    U64 magic;
+    U64 shift;
+    U64 offset;
 
-    /// @brief [Internal Usage] Slow function to calculate bishop attacks
-    /// @param sq
-    /// @param occupied
-    /// @return
-    [[nodiscard]] static Bitboard bishopAttacks(Square sq, Bitboard occupied);
+#ifdef CHESS_USE_PEXT
+    U64 operator()(U64 b) const { return _pext_u64(b, mask); }
+#else
+    U64 operator()(U64 b) const { return ((b & mask) * magic) >> shift; }
+#endif
+};
 
-    /// @brief [Internal Usage] Slow function to calculate rook attacks
-    /// @param sq
-    /// @param occupied
-    /// @return
-    [[nodiscard]] static Bitboard rookAttacks(Square sq, Bitboard occupied);
+// precomputed by gen_slider_tables.py, so there is nothing to initialize at startup
+#include "slider_tables.hpp"
 
-    /// @brief [Internal Usage] Initializes the magic bitboard tables for sliding pieces
-    /// @param sq
-    /// @param table
-    /// @param magic
-    /// @param attacks
-    static void initSliders(Square sq, Magic table[], U64 magic,
-                            const std::function<Bitboard(Square, Bitboard)> &attacks);
+}  // namespace slider_tables
+
+/****************************************************************************\
+ * attacks Forward Declaration                                               *
+\****************************************************************************/
+
+class attacks {
+   public:
+    /// @brief Name of the slider attack backend this build uses
+    /// @return
+    [[nodiscard]] static constexpr const char *sliderBackend() {
+#ifdef CHESS_USE_PEXT
+        return "pext";
+#else
+        return "magic";
+#endif
+    }
 
+   private:
     // clang-format off
     // pre-calculated lookup table for pawn attacks
     static constexpr Bitboard PawnAttacks[2][constants::MAX_SQ] = {
@@ -1065,48 +1080,6 @@ class attacks {
         0x0203000000000000, 0x0507000000000000, 0x0A0E000000000000, 0x141C000000000000,
         0x2838000000000000, 0x5070000000000000, 0xA0E0000000000000, 0x40C0000000000000};
 
-    static constexpr Bitboard RookMagics[constants::MAX_SQ] = {
-        0x8a80104000800020ULL, 0x140002000100040ULL,  0x2801880a0017001ULL,  0x100081001000420ULL,
-        0x200020010080420ULL,  0x3001c0002010008ULL,  0x8480008002000100ULL, 0x2080088004402900ULL,
-        0x800098204000ULL,     0x2024401000200040ULL, 0x100802000801000ULL,  0x120800800801000ULL,
-        0x208808088000400ULL,  0x2802200800400ULL,    0x2200800100020080ULL, 0x801000060821100ULL,
-        0x80044006422000ULL,   0x100808020004000ULL,  0x12108a0010204200ULL, 0x140848010000802ULL,
-        0x481828014002800ULL,  0x8094004002004100ULL, 0x4010040010010802ULL, 0x20008806104ULL,
-        0x100400080208000ULL,  0x2040002120081000ULL, 0x21200680100081ULL,   0x20100080080080ULL,
-        0x2000a00200410ULL,    0x20080800400ULL,      0x80088400100102ULL,   0x80004600042881ULL,
-        0x4040008040800020ULL, 0x440003000200801ULL,  0x4200011004500ULL,    0x188020010100100ULL,
-        0x14800401802800ULL,   0x2080040080800200ULL, 0x124080204001001ULL,  0x200046502000484ULL,
-        0x480400080088020ULL,  0x1000422010034000ULL, 0x30200100110040ULL,   0x100021010009ULL,
-        0x2002080100110004ULL, 0x202008004008002ULL,  0x20020004010100ULL,   0x2048440040820001ULL,
-        0x101002200408200ULL,  0x40802000401080ULL,   0x4008142004410100ULL, 0x2060820c0120200ULL,
-        0x1001004080100ULL,    0x20c020080040080ULL,  0x2935610830022400ULL, 0x44440041009200ULL,
-        0x280001040802101ULL,  0x2100190040002085ULL, 0x80c0084100102001ULL, 0x4024081001000421ULL,
-        0x20030a0244872ULL,    0x12001008414402ULL,   0x2006104900a0804ULL,  0x1004081002402ULL};
-
-    static constexpr Bitboard BishopMagics[constants::MAX_SQ] = {
-        0x40040844404084ULL,   0x2004208a004208ULL,   0x10190041080202ULL,   0x108060845042010ULL,
-        0x581104180800210ULL,  0x2112080446200010ULL, 0x1080820820060210ULL, 0x3c0808410220200ULL,
-        0x4050404440404ULL,    0x21001420088ULL,      0x24d0080801082102ULL, 0x1020a0a020400ULL,
-        0x40308200402ULL,      0x4011002100800ULL,    0x401484104104005ULL,  0x801010402020200ULL,
-        0x400210c3880100ULL,   0x404022024108200ULL,  0x810018200204102ULL,  0x4002801a02003ULL,
-        0x85040820080400ULL,   0x810102c808880400ULL, 0xe900410884800ULL,    0x8002020480840102ULL,
-        0x220200865090201ULL,  0x2010100a02021202ULL, 0x152048408022401ULL,  0x20080002081110ULL,
-        0x4001001021004000ULL, 0x800040400a011002ULL, 0xe4004081011002ULL,   0x1c004001012080ULL,
-        0x8004200962a00220ULL, 0x8422100208500202ULL, 0x2000402200300c08ULL, 0x8646020080080080ULL,
-        0x80020a0200100808ULL, 0x2010004880111000ULL, 0x623000a080011400ULL, 0x42008c0340209202ULL,
-        0x209188240001000ULL,  0x400408a884001800ULL, 0x110400a6080400ULL,   0x1840060a44020800ULL,
-        0x90080104000041ULL,   0x201011000808101ULL,  0x1a2208080504f080ULL, 0x8012020600211212ULL,
-        0x500861011240000ULL,  0x180806108200800ULL,  0x4000020e01040044ULL, 0x300000261044000aULL,
-        0x802241102020002ULL,  0x20906061210001ULL,   0x5a84841004010310ULL, 0x4010801011c04ULL,
-        0xa010109502200ULL,    0x4a02012000ULL,       0x500201010098b028ULL, 0x8040002811040900ULL,
-        0x28000010020204ULL,   0x6000020202d0240ULL,  0x8918844842082200ULL, 0x4010011029020020ULL};
-
-    static inline Bitboard RookAttacks[0x19000]  = {};
-    static inline Bitboard BishopAttacks[0x1480] = {};
-
-    static inline Magic RookTable[constants::MAX_SQ]   = {};
-    static inline Magic BishopTable[constants::MAX_SQ] = {};
-
    public:
     static constexpr Bitboard MASK_RANK[8] = {
         0xff,         0xff00,         0xff0000,         0xff000000,
@@ -1180,10 +1153,6 @@ class attacks {
     /// @return
     [[nodiscard]] static Bitboard attackers(const Board &board, Color color, Square square,
                                             Bitboard occupied);
-
-    /// @brief [Internal Usage] Initializes the attacks for the bishop and rook. Called once at
-    /// startup.
-    static inline void initAttacks();
 };
 
 /****************************************************************************\
@@ -1307,6 +1276,8 @@ class Board {
         uint8_t half_moves;
         Piece captured_piece;
 
+        State() = default;
+
         State(const U64 &hash, const CastlingRights &castling, const Square &enpassant,
               const uint8_t &half_moves, const Piece &captured_piece)
             : hash(hash),
@@ -1316,6 +1287,40 @@ class Board {
               captured_piece(captured_piece) {}
     };
 
+    /// @brief Fixed capacity stack of previous states, stored inline so that
+    /// makeMove never allocates. Sized for a long game plus a full search.
+    /// If it ever fills up, the oldest half is dropped. That history is
+    /// older than any halfmove clock, so isRepetition never looks at it.
+    class StateStack {
+       public:
+        static constexpr int CAPACITY = 1024;
+
+        template <typename... Args>
+        void emplace_back(Args &&...args) {
+            if (size_ == CAPACITY) compact();
+            states_[size_++] = State(std::forward<Args>(args)...);
+        }
+
+        void pop_back() {
+            assert(size_ > 0);
+            size_--;
+        }
+
+        [[nodiscard]] const State &back() const { return states_[size_ - 1]; }
+        [[nodiscard]] const State &operator[](int i) const { return states_[i]; }
+        [[nodiscard]] int size() const { return size_; }
+        void clear() { size_ = 0; }
+
+       private:
+        void compact() {
+            std::copy(states_.begin() + CAPACITY / 2, states_.end(), states_.begin());
+            size_ = CAPACITY / 2;
+        }
+
+        std::array<State, CAPACITY> states_;
+        int size_ = 0;
+    };
+
    public:
     explicit Board(std::string_view fen = constants::STARTPOS);
 
@@ -1411,6 +1416,19 @@ class Board {
     /// @brief Get the current hash key of the board
     /// @return
     [[nodiscard]] U64 hash() const { return hash_key_; }
+
+    /// @brief Get the material key of the board, the number of each piece type per color
+    /// (kings left out) packed into 4 bits each, updated incrementally like the hash
+    /// @return
+    [[nodiscard]] U64 materialKey() const { return material_key_; }
+
+    /// @brief Material key contribution of a single piece
+    /// @param piece
+    /// @return
+    [[nodiscard]] static U64 materialKeyOf(Piece piece) {
+        if (piece == Piece::NONE || utils::typeOfPiece(piece) == PieceType::KING) return 0ULL;
+        return 1ULL << (4 * (5 * int(color(piece)) + int(utils::typeOfPiece(piece))));
+    }
     [[nodiscard]] Color sideToMove() const { return side_to_move_; }
     [[nodiscard]] Square enpassantSq() const { return enpassant_sq_; }
     [[nodiscard]] CastlingRights castlingRights() const { return castling_rights_; }
@@ -1492,13 +1510,14 @@ class Board {
     virtual void placePiece(Piece piece, Square sq);
     virtual void removePiece(Piece piece, Square sq);
 
-    std::vector<State> prev_states_;
+    StateStack prev_states_;
 
     U64 pieces_bb_[2][6]         = {};
     std::array<Piece, 64> board_ = {};
 
-    U64 hash_key_ = 0ULL;
-    U64 occ_all_  = 0ULL;
+    U64 hash_key_     = 0ULL;
+    U64 material_key_ = 0ULL;
+    U64 occ_all_      = 0ULL;
 
     CastlingRights castling_rights_ = {};
     uint16_t plies_played_          = 0;
@@ -1530,7 +1549,8 @@ inline void Board::setFenInternal(std::string_view fen) {
     // find leading whitespaces and remove them
     while (fen[0] == ' ') fen.remove_prefix(1);
 
-    occ_all_ = 0ULL;
+    occ_all_      = 0ULL;
+    material_key_ = 0ULL;
 
     for (const auto c : {Color::WHITE, Color::BLACK}) {
         for (int i = 0; i < 6; i++) {
@@ -1655,7 +1675,6 @@ inline void Board::setFenInternal(std::string_view fen) {
     occ_all_  = all();
 
     prev_states_.clear();
-    prev_states_.reserve(150);
 }
 
 inline void Board::setFen(std::string_view fen) { setFenInternal(fen); }
@@ -1812,10 +1831,14 @@ inline std::string Board::getCastleString() const {
 }
 
 inline bool Board::isRepetition(int count) const {
+    // a position needs at least 4 reversible plies to come back
+    if (half_moves_ < 4) return false;
+
     uint8_t c = 0;
 
-    for (int i = static_cast<int>(prev_states_.size()) - 2;
-         i >= 0 && i >= static_cast<int>(prev_states_.size()) - half_moves_ - 1; i -= 2) {
+    // 2 plies back can never match, and nothing before the last irreversible move can
+    for (int i = prev_states_.size() - 4; i >= 0 && i >= prev_states_.size() - half_moves_ - 1;
+         i -= 2) {
         if (prev_states_[i].hash == hash_key_) c++;
 
         if (c == count) return true;
@@ -1825,23 +1848,20 @@ inline bool Board::isRepetition(int count) const {
 }
 
 inline bool Board::isInsufficientMaterial() const {
-    const auto count = builtin::popcount(occ());
+    const auto key = materialKey();
 
-    if (count == 2) return true;
+    if (key == 0ULL) return true;
 
-    if (count == 3) {
-        if (pieces(PieceType::BISHOP, Color::WHITE) || pieces(PieceType::BISHOP, Color::BLACK))
-            return true;
-        if (pieces(PieceType::KNIGHT, Color::WHITE) || pieces(PieceType::KNIGHT, Color::BLACK))
-            return true;
-    }
+    // a single minor piece
+    if (key == materialKeyOf(Piece::WHITEBISHOP) || key == materialKeyOf(Piece::BLACKBISHOP) ||
+        key == materialKeyOf(Piece::WHITEKNIGHT) || key == materialKeyOf(Piece::BLACKKNIGHT))
+        return true;
 
-    if (count == 4) {
-        if (pieces(PieceType::BISHOP, Color::WHITE) && pieces(PieceType::BISHOP, Color::BLACK) &&
-            utils::sameColor(builtin::lsb(pieces(PieceType::BISHOP, Color::WHITE)),
-                             builtin::lsb(pieces(PieceType::BISHOP, Color::BLACK))))
-            return true;
-    }
+    // one bishop each on the same color
+    if (key == materialKeyOf(Piece::WHITEBISHOP) + materialKeyOf(Piece::BLACKBISHOP) &&
+        utils::sameColor(builtin::lsb(pieces(PieceType::BISHOP, Color::WHITE)),
+                         builtin::lsb(pieces(PieceType::BISHOP, Color::BLACK))))
+        return true;
 
     return false;
 }
@@ -1898,6 +1918,7 @@ inline void Board::placePiece(Piece piece, Square sq) {
     board_[sq] = piece;
 
     occ_all_ |= (1ULL << sq);
+    material_key_ += materialKeyOf(piece);
 }
 
 inline void Board::removePiece(Piece piece, Square sq) {
@@ -1908,6 +1929,7 @@ inline void Board::removePiece(Piece piece, Square sq) {
     pieces_bb_[int(color(piece))][int(utils::typeOfPiece(piece))] &= ~(1ULL << sq);
 
     occ_all_ &= ~(1ULL << sq);
+    material_key_ -= materialKeyOf(piece);
 }
 
 inline void Board::makeMove(const Move &move) {
@@ -2207,7 +2229,8 @@ template <Color c>
 /// @param occupied
 /// @return
 [[nodiscard]] inline Bitboard attacks::bishop(Square sq, Bitboard occupied) {
-    return BishopTable[sq].attacks[BishopTable[sq](occupied)];
+    const auto &m = slider_tables::BISHOP_MAGICS[sq];
+    return slider_tables::BISHOP_ATTACKS[m.offset + m(occupied)];
 }
 
 /// @brief Returns the rook attacks for a given square
@@ -2215,7 +2238,8 @@ template <Color c>
 /// @param occupied
 /// @return
 [[nodiscard]] inline Bitboard attacks::rook(Square sq, Bitboard occupied) {
-    return RookTable[sq].attacks[RookTable[sq](occupied)];
+    const auto &m = slider_tables::ROOK_MAGICS[sq];
+    return slider_tables::ROOK_ATTACKS[m.offset + m(occupied)];
 }
 
 /// @brief Returns the queen attacks for a given square
@@ -2251,133 +2275,6 @@ template <Color c>
     return atks & occupied;
 }
 
-/// @brief [Internal Usage] Slow function to calculate bishop attacks
-/// @param sq
-/// @param occupied
-/// @return
-[[nodiscard]] inline Bitboard attacks::bishopAttacks(Square sq, Bitboard occupied) {
-    Bitboard attacks = 0ULL;
-
-    int r, f;
-
-    int br = sq / 8;
-    int bf = sq % 8;
-
-    for (r = br + 1, f = bf + 1; utils::validSq(static_cast<Rank>(r), static_cast<File>(f));
-         r++, f++) {
-        Square s = utils::makeSquare(static_cast<Rank>(r), static_cast<File>(f));
-        attacks |= (1ULL << s);
-        if (occupied & (1ULL << s)) break;
-    }
-
-    for (r = br - 1, f = bf + 1; utils::validSq(static_cast<Rank>(r), static_cast<File>(f));
-         r--, f++) {
-        Square s = utils::makeSquare(static_cast<Rank>(r), static_cast<File>(f));
-        attacks |= (1ULL << s);
-        if (occupied & (1ULL << s)) break;
-    }
-
-    for (r = br + 1, f = bf - 1; utils::validSq(static_cast<Rank>(r), static_cast<File>(f));
-         r++, f--) {
-        Square s = utils::makeSquare(static_cast<Rank>(r), static_cast<File>(f));
-        attacks |= (1ULL << s);
-        if (occupied & (1ULL << s)) break;
-    }
-
-    for (r = br - 1, f = bf - 1; utils::validSq(static_cast<Rank>(r), static_cast<File>(f));
-         r--, f--) {
-        Square s = utils::makeSquare(static_cast<Rank>(r), static_cast<File>(f));
-        attacks |= (1ULL << s);
-        if (occupied & (1ULL << s)) break;
-    }
-
-    return attacks;
-}
-
-/// @brief [Internal Usage] Slow function to calculate rook attacks
-/// @param sq
-/// @param occupied
-/// @return
-[[nodiscard]] inline Bitboard attacks::rookAttacks(Square sq, Bitboard occupied) {
-    Bitboard attacks = 0ULL;
-
-    int r, f;
-
-    int rr = sq / 8;
-    int rf = sq % 8;
-
-    for (r = rr + 1; utils::validSq(static_cast<Rank>(r), static_cast<File>(rf)); r++) {
-        Square s = utils::makeSquare(static_cast<Rank>(r), static_cast<File>(rf));
-        attacks |= (1ULL << s);
-        if (occupied & (1ULL << s)) break;
-    }
-
-    for (r = rr - 1; utils::validSq(static_cast<Rank>(r), static_cast<File>(rf)); r--) {
-        Square s = utils::makeSquare(static_cast<Rank>(r), static_cast<File>(rf));
-        attacks |= (1ULL << s);
-        if (occupied & (1ULL << s)) break;
-    }
-
-    for (f = rf + 1; utils::validSq(static_cast<Rank>(rr), static_cast<File>(f)); f++) {
-        Square s = utils::makeSquare(static_cast<Rank>(rr), static_cast<File>(f));
-        attacks |= (1ULL << s);
-        if (occupied & (1ULL << s)) break;
-    }
-
-    for (f = rf - 1; utils::validSq(static_cast<Rank>(rr), static_cast<File>(f)); f--) {
-        Square s = utils::makeSquare(static_cast<Rank>(rr), static_cast<File>(f));
-        attacks |= (1ULL << s);
-        if (occupied & (1ULL << s)) break;
-    }
-
-    return attacks;
-}
-
-/// @brief [Internal Usage] Initializes the magic bitboard tables for sliding pieces
-/// @param sq
-/// @param table
-/// @param magic
-/// @param attacks
-inline void attacks::initSliders(Square sq, Magic table[], U64 magic,
-                                 const std::function<Bitboard(Square, Bitboard)> &attacks) {
-    const Bitboard edges =
-        ((MASK_RANK[static_cast<int>(Rank::RANK_1)] | MASK_RANK[static_cast<int>(Rank::RANK_8)]) &
-         ~MASK_RANK[static_cast<int>(utils::squareRank(sq))]) |
-        ((MASK_FILE[static_cast<int>(File::FILE_A)] | MASK_FILE[static_cast<int>(File::FILE_H)]) &
-         ~MASK_FILE[static_cast<int>(utils::squareFile(sq))]);
-
-    Bitboard occ = 0ULL;
-
-    table[sq].magic = magic;
-    table[sq].mask  = attacks(sq, occ) & ~edges;
-    table[sq].shift = constants::MAX_SQ - builtin::popcount(table[sq].mask);
-
-    if (sq < constants::MAX_SQ - 1) {
-        table[sq + 1].attacks = table[sq].attacks + (1 << builtin::popcount(table[sq].mask));
-    }
-
-    do {
-        table[sq].attacks[table[sq](occ)] = attacks(sq, occ);
-        occ                               = (occ - table[sq].mask) & table[sq].mask;
-    } while (occ);
-}
-
-/// @brief [Internal Usage] Initializes the attacks for the bishop and rook. Called once at
-/// startup.
-inline void attacks::initAttacks() {
-    BishopTable[0].attacks = BishopAttacks;
-    RookTable[0].attacks   = RookAttacks;
-
-    for (int i = 0; i < constants::MAX_SQ; i++) {
-        initSliders(static_cast<Square>(i), BishopTable, BishopMagics[i], bishopAttacks);
-        initSliders(static_cast<Square>(i), RookTable, RookMagics[i], rookAttacks);
-    }
-}
-
-static auto init = []() {
-    attacks::initAttacks();
-    return 0;
-}();
 
 /****************************************************************************\
  * Move Generation                                                           *
@@ -2987,6 +2884,139 @@ inline void legalmoves(Movelist &movelist, const Board &board, int pieces) {
         legalmoves<Color::BLACK, mt>(movelist, board, pieces);
 }
 
+/// @brief [Internal Usage] all pseudo legal moves for a position
+/// @tparam c
+/// @tparam mt
+/// @param movelist
+/// @param board
+template <Color c, MoveGenType mt>
+void pseudolegalmoves(Movelist &movelist, const Board &board) {
+    const auto king_sq = board.kingSq(c);
+
+    const Bitboard occ_us    = board.us(c);
+    const Bitboard occ_enemy = board.us(~c);
+    const Bitboard occ_all   = occ_us | occ_enemy;
+
+    Bitboard movable_square;
+    if (mt == MoveGenType::ALL)
+        movable_square = ~occ_us;
+    else if (mt == MoveGenType::CAPTURE)
+        movable_square = occ_enemy;
+    else  // QUIET moves
+        movable_square = ~occ_all;
+
+    whileBitboardAdd(movelist, 1ull << king_sq,
+                     [&](Square sq) { return attacks::king(sq) & movable_square; });
+
+    // castling is rare enough that it is still generated fully legal
+    if (mt != MoveGenType::CAPTURE &&
+        utils::squareRank(king_sq) == (c == Color::WHITE ? Rank::RANK_1 : Rank::RANK_8) &&
+        board.castlingRights().hasCastlingRight(c)) {
+        const Bitboard seen = seenSquares<~c>(board, ~occ_us);
+
+        if (!(seen & (1ull << king_sq))) {
+            const Bitboard pin_hv = pinMaskRooks<c>(board, king_sq, occ_enemy, occ_us);
+            Bitboard moves_bb     = generateCastleMoves<c, mt>(board, king_sq, seen, pin_hv);
+
+            while (moves_bb) {
+                Square to = builtin::poplsb(moves_bb);
+                movelist.add(Move::make<Move::CASTLING>(king_sq, to));
+            }
+        }
+    }
+
+    generatePawnMoves<c, mt>(board, movelist, 0ull, 0ull, constants::DEFAULT_CHECKMASK,
+                             occ_enemy);
+
+    whileBitboardAdd(movelist, board.pieces(PieceType::KNIGHT, c),
+                     [&](Square sq) { return attacks::knight(sq) & movable_square; });
+
+    whileBitboardAdd(movelist, board.pieces(PieceType::BISHOP, c),
+                     [&](Square sq) { return attacks::bishop(sq, occ_all) & movable_square; });
+
+    whileBitboardAdd(movelist, board.pieces(PieceType::ROOK, c),
+                     [&](Square sq) { return attacks::rook(sq, occ_all) & movable_square; });
+
+    whileBitboardAdd(movelist, board.pieces(PieceType::QUEEN, c),
+                     [&](Square sq) { return attacks::queen(sq, occ_all) & movable_square; });
+}
+
+/// @brief Generates all pseudo legal moves for a position: moves may leave the own king
+/// in check, which isLegal() has to filter out. Castling moves are always legal.
+/// The movelist will be emptied before adding the moves.
+/// @tparam mt
+/// @param movelist
+/// @param board
+template <MoveGenType mt = MoveGenType::ALL>
+inline void pseudolegalmoves(Movelist &movelist, const Board &board) {
+    movelist.clear();
+
+    if (board.sideToMove() == Color::WHITE)
+        pseudolegalmoves<Color::WHITE, mt>(movelist, board);
+    else
+        pseudolegalmoves<Color::BLACK, mt>(movelist, board);
+}
+
+/// @brief Pieces of color c that are pinned to their own king.
+/// @param board
+/// @param c
+/// @return
+[[nodiscard]] inline Bitboard pinnedPieces(const Board &board, Color c) {
+    const Square king_sq     = board.kingSq(c);
+    const Bitboard occ_enemy = board.us(~c);
+    const Bitboard queens    = board.pieces(PieceType::QUEEN, ~c);
+
+    // enemy sliders that would see the king if only enemy pieces were on the board
+    Bitboard snipers =
+        (attacks::rook(king_sq, occ_enemy) & (board.pieces(PieceType::ROOK, ~c) | queens)) |
+        (attacks::bishop(king_sq, occ_enemy) & (board.pieces(PieceType::BISHOP, ~c) | queens));
+
+    Bitboard pinned = 0ull;
+
+    while (snipers) {
+        const Square sq        = builtin::poplsb(snipers);
+        const Bitboard between = SQUARES_BETWEEN_BB[king_sq][sq] & board.occ();
+
+        if (builtin::popcount(between) == 1) pinned |= between & board.us(c);
+    }
+
+    return pinned;
+}
+
+/// @brief Checks if a move from pseudolegalmoves() is legal.
+/// Only king moves, en passant, pinned pieces and moves while in check need real work.
+/// @param board
+/// @param move
+/// @param pinned pinnedPieces() for the side to move
+/// @param in_check whether the side to move is in check
+/// @return
+[[nodiscard]] inline bool isLegal(const Board &board, const Move &move, Bitboard pinned,
+                                  bool in_check) {
+    const Color c        = board.sideToMove();
+    const Square king_sq = board.kingSq(c);
+    const Square from    = move.from();
+    const Square to      = move.to();
+
+    if (move.typeOf() == Move::CASTLING) return true;
+
+    if (from == king_sq) {
+        // the king must not be attacked on the new square, sliders see through its old one
+        return !attacks::attackers(board, ~c, to, board.occ() ^ (1ull << king_sq));
+    }
+
+    if (move.typeOf() == Move::ENPASSANT) {
+        const Square captured = Square(to ^ 8);
+        const Bitboard occ    = (board.occ() ^ (1ull << from) ^ (1ull << captured)) | (1ull << to);
+        return !attacks::attackers(board, ~c, king_sq, occ);
+    }
+
+    if (!in_check && !(pinned & (1ull << from))) return true;
+
+    // anything captured on the target square can no longer attack the king
+    const Bitboard occ = (board.occ() ^ (1ull << from)) | (1ull << to);
+    return !(attacks::attackers(board, ~c, king_sq, occ) & ~(1ull << to));
+}
+
 }  // namespace movegen
 
 /****************************************************************************\
@@ -0,0 +1,359 @@
+// exact knowledge for small endgames the normal evaluation has no feel for
+// the evaluator looks the material key (kept up to date by the board) up in a table of specialized
+// evaluators first, and only falls back to the tuned terms when there is none. Right now that is:
+//   KPK  - exact win/draw from a bitbase, generated by retrograde analysis the first time it is needed
+//   KBNK - drives the king to a corner of the bishop's color
+//   KXK  - any mating material against a bare king (KQK, KRK, ...), drives the king to the edge
+//   KNNK - can't be forced, so it is scored as a draw
+// some material is known to be drawish without being a draw, there a scale function shrinks the
+// general evaluation instead of replacing it:
+//   KRKR             - almost always drawn
+//   opposite bishops - one bishop each on different colors and only pawns besides
+// a new endgame is a function taking the board and the strong side, plus one add() or addScale() call in Endgames
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+#include <cstdlib>
+#include <algorithm>
+#include "chess.hpp"
+
+using namespace chess;
+
+// about what winning a queen is worth, known wins score above it so the search heads for them
+const int KNOWN_WIN = 2000;
+
+// counts of every piece type but kings, 4 bits each, so every material balance has its own key
+// (the board updates it in placePiece/removePiece, so this is free)
+inline uint64_t materialKey(const Board& board) {
+    return board.materialKey();
+}
+
+// the key of a material code like "KBNK", the pieces before the second king belong to strong
+inline uint64_t materialKey(const std::string& code, Color strong) {
+    const std::string pieceChars = "PNBRQ";
+    uint64_t key = 0;
+    int side = static_cast<int>(strong);
+    for (size_t i = 1; i < code.size(); i++) {
+        if (code[i] == 'K') {
+            side = 1 - side;
+            continue;
+        }
+        key += uint64_t(1) << (4 * (5 * side + pieceChars.find(code[i])));
+    }
+    return key;
+}
+
+// win or draw for every KPK position with white having the pawn, 1 bit each (24KB)
+// positions are indexed like in stockfish: the pawn is kept on files a-d by mirroring, so there are
+// 24 pawn squares x 64 x 64 king squares x 2 sides to move
+class KPKBitbase {
+public:
+    // does white win with the pawn on wp, from white's side, pawn on ranks 2 to 7
+    static bool probe(Square wk, Square wp, Square bk, Color sideToMove) {
+        if (utils::squareFile(wp) >= File::FILE_E) {
+            wk = Square(wk ^ 7);
+            wp = Square(wp ^ 7);
+            bk = Square(bk ^ 7);
+        }
+        const int i = index(sideToMove == Color::WHITE ? 0 : 1, bk, wk, wp);
+        return instance().bits[i / 64] >> (i % 64) & 1;
+    }
+
+private:
+    static const int MAX_INDEX = 2 * 24 * 64 * 64;
+    uint64_t bits[MAX_INDEX / 64] = {};
+
+    enum Result : uint8_t {
+        INVALID = 0,
+        UNKNOWN = 1,
+        DRAW = 2,
+        WIN = 4
+    };
+
+    static const KPKBitbase& instance() {
+        static const KPKBitbase bitbase; // built on first use, takes a few milliseconds
+        return bitbase;
+    }
+
+    static int index(int stm, int bk, int wk, int wp) {
+        return wk | (bk << 6) | (stm << 12) | ((wp & 7) << 13) | ((6 - (wp >> 3)) << 15);
+    }
+
+    // retrograde analysis: classify what is obvious, then keep going over the rest until nothing changes
+    KPKBitbase() {
+        std::vector<uint8_t> db(MAX_INDEX, UNKNOWN);
+        for (int i = 0; i < MAX_INDEX; i++) {
+            db[i] = classifyInitial(i);
+        }
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int i = 0; i < MAX_INDEX; i++) {
+                if (db[i] == UNKNOWN && (db[i] = classify(db, i)) != UNKNOWN) {
+                    changed = true;
+                }
+            }
+        }
+        for (int i = 0; i < MAX_INDEX; i++) {
+            if (db[i] == WIN) {
+                bits[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+    }
+
+    static void decode(int i, int& stm, int& bk, int& wk, int& wp) {
+        wk = i & 63;
+        bk = (i >> 6) & 63;
+        stm = (i >> 12) & 1;
+        wp = ((6 - (i >> 15)) << 3) | ((i >> 13) & 3);
+    }
+
+    static uint8_t classifyInitial(int i) {
+        int stm, bk, wk, wp;
+        decode(i, stm, bk, wk, wp);
+        const Bitboard pawnAttacks = attacks::pawn(Color::WHITE, Square(wp));
+        const Bitboard whiteKingAttacks = attacks::king(Square(wk));
+
+        // kings touching, a piece on top of another, or black in check with white to move
+        if (utils::squareDistance(Square(wk), Square(bk)) <= 1 || wk == wp || bk == wp
+            || (stm == 0 && (pawnAttacks & (1ULL << bk)))) {
+            return INVALID;
+        }
+        // the pawn promotes and can't be taken right away
+        const int promotion = wp + 8;
+        if (stm == 0 && (wp >> 3) == 6 && wk != promotion && bk != promotion
+            && (utils::squareDistance(Square(bk), Square(promotion)) > 1 || utils::squareDistance(Square(wk), Square(promotion)) == 1)) {
+            return WIN;
+        }
+        // stalemate, or black takes the pawn for free
+        if (stm == 1) {
+            const Bitboard blackKingAttacks = attacks::king(Square(bk));
+            if (!(blackKingAttacks & ~(whiteKingAttacks | pawnAttacks))
+                || (blackKingAttacks & (1ULL << wp) & ~whiteKingAttacks)) {
+                return DRAW;
+            }
+        }
+        return UNKNOWN;
+    }
+
+    // white wins if any move wins, black draws if any move draws
+    static uint8_t classify(const std::vector<uint8_t>& db, int i) {
+        int stm, bk, wk, wp;
+        decode(i, stm, bk, wk, wp);
+        const uint8_t good = stm == 0 ? WIN : DRAW;
+        const uint8_t bad = stm == 0 ? DRAW : WIN;
+
+        uint8_t r = INVALID;
+        Bitboard kingMoves = attacks::king(Square(stm == 0 ? wk : bk));
+        while (kingMoves) {
+            const int to = builtin::poplsb(kingMoves);
+            r |= stm == 0 ? db[index(1, bk, to, wp)] : db[index(0, to, wk, wp)];
+        }
+        if (stm == 0) {
+            if ((wp >> 3) < 6) {
+                r |= db[index(1, bk, wk, wp + 8)];
+            }
+            if ((wp >> 3) == 1 && wp + 8 != wk && wp + 8 != bk) {
+                r |= db[index(1, bk, wk, wp + 16)];
+            }
+        }
+        return (r & good) ? good : (r & UNKNOWN) ? static_cast<uint8_t>(UNKNOWN) : bad;
+    }
+};
+
+// a specialized evaluation, from the strong side's point of view
+// draw is set when the position is a certain draw, which the search can cut off right away
+struct EndgameScore {
+    int score = 0;
+    bool draw = false;
+};
+
+using EndgameFunction = EndgameScore (*)(const Board& board, Color strong);
+
+// how much of the general evaluation to keep, 1 changes nothing and 0 makes it a dead draw
+using ScaleFunction = float (*)(const Board& board, Color strong);
+
+// 0 in the corners, 6 in the center, for pushing a king around
+inline int edgeDistance(Square sq) {
+    const int file = static_cast<int>(utils::squareFile(sq));
+    const int rank = static_cast<int>(utils::squareRank(sq));
+    return std::min(file, 7 - file) + std::min(rank, 7 - rank);
+}
+
+inline Square kingSquare(const Board& board, Color color) {
+    return builtin::lsb(board.pieces(PieceType::KING, color));
+}
+
+inline EndgameScore evaluateKPK(const Board& board, Color strong) {
+    // look at it as if white had the pawn
+    auto normalize = [strong](Square sq) { return strong == Color::WHITE ? sq : Square(sq ^ 56); };
+    const Square wk = normalize(kingSquare(board, strong));
+    const Square bk = normalize(kingSquare(board, ~strong));
+    const Square wp = normalize(builtin::lsb(board.pieces(PieceType::PAWN, strong)));
+    const Color stm = board.sideToMove() == strong ? Color::WHITE : Color::BLACK;
+
+    if (!KPKBitbase::probe(wk, wp, bk, stm)) {
+        return {0, true};
+    }
+    return {KNOWN_WIN + 100 + 10 * static_cast<int>(utils::squareRank(wp)), false};
+}
+
+// any mating material against a bare king: push the king to the edge and bring ours closer
+inline EndgameScore evaluateKXK(const Board& board, Color strong) {
+    const int values[5] = {100, 300, 300, 500, 900};
+    int material = 0;
+    for (int pt = 0; pt < 5; pt++) {
+        material += values[pt] * builtin::popcount(board.pieces(PieceType(pt), strong));
+    }
+    const Square strongKing = kingSquare(board, strong);
+    const Square weakKing = kingSquare(board, ~strong);
+    return {KNOWN_WIN + material + 20 * (6 - edgeDistance(weakKing)) + 10 * (7 - utils::squareDistance(strongKing, weakKing)), false};
+}
+
+// bishop and knight mate: only the corners of the bishop's color work, so push towards those
+inline EndgameScore evaluateKBNK(const Board& board, Color strong) {
+    const Square strongKing = kingSquare(board, strong);
+    Square weakKing = kingSquare(board, ~strong);
+    const Square bishop = builtin::lsb(board.pieces(PieceType::BISHOP, strong));
+    // a1 and h8 are dark, on a light bishop mirror the board so its corners are a1 and h8
+    const bool darkBishop = ((static_cast<int>(utils::squareFile(bishop)) + static_cast<int>(utils::squareRank(bishop))) & 1) == 0;
+    if (!darkBishop) {
+        weakKing = Square(weakKing ^ 7);
+    }
+    const int cornerDistance = std::min(utils::squareDistance(weakKing, SQ_A1), utils::squareDistance(weakKing, SQ_H8));
+    return {KNOWN_WIN + 600 + 20 * (7 - cornerDistance) + 10 * (7 - utils::squareDistance(strongKing, kingSquare(board, ~strong))), false};
+}
+
+// two knights can't force mate, the search still finds one if the other side walks into it
+inline EndgameScore evaluateKNNK(const Board&, Color) {
+    return {0, false};
+}
+
+// rook against rook is a draw unless something hangs right away, which the search sees anyway
+inline float scaleKRKR(const Board&, Color) {
+    return 0.1f;
+}
+
+// opposite colored bishops: the defending king sits on the squares the other bishop can't touch,
+// so even a pawn or two up is often not enough
+inline float scaleOppositeBishops(const Board& board, Color) {
+    const int pawnDifference = std::abs(builtin::popcount(board.pieces(PieceType::PAWN, Color::WHITE))
+                                        - builtin::popcount(board.pieces(PieceType::PAWN, Color::BLACK)));
+    return pawnDifference <= 1 ? 0.25f : 0.5f;
+}
+
+// the specialized evaluators, keyed by material
+class Endgames {
+public:
+    static const Endgames& instance() {
+        static const Endgames endgames;
+        return endgames;
+    }
+
+    // score from white's point of view if there is a specialized evaluator for this material
+    // otherwise scale is what the general evaluation should be multiplied with
+    bool probe(const Board& board, EndgameScore& result, float& scale) const {
+        Color strong = Color::WHITE;
+        EndgameFunction function = nullptr;
+        scale = 1.0f;
+        const uint64_t key = materialKey(board);
+        if (builtin::popcount(board.occ()) <= maxPieces) {
+            auto entry = table.find(key);
+            if (entry != table.end()) {
+                function = entry->second.function;
+                strong = entry->second.strong;
+                if (entry->second.scale) {
+                    scale = entry->second.scale(board, strong);
+                }
+            }
+        }
+        if (!function && isOppositeBishops(board, key)) {
+            scale = scaleOppositeBishops(board, Color::WHITE);
+        }
+        if (!function && !(function = bareKing(board, strong))) {
+            return false;
+        }
+        result = function(board, strong);
+        if (strong == Color::BLACK) {
+            result.score = -result.score;
+        }
+        return true;
+    }
+
+    bool probe(const Board& board, EndgameScore& result) const {
+        float scale;
+        return probe(board, result, scale);
+    }
+
+    // only table entries can be a certain draw, so with more pieces on the board there is no
+    // point in probing for one
+    int maxPieceCount() const {
+        return maxPieces;
+    }
+
+private:
+    struct Entry {
+        EndgameFunction function = nullptr;
+        ScaleFunction scale = nullptr;
+        Color strong = Color::WHITE;
+    };
+
+    // the part of the material key without the pawns
+    static const uint64_t PIECES_MASK = ~((uint64_t(0xF) << 0) | (uint64_t(0xF) << 20));
+
+    std::unordered_map<uint64_t, Entry> table;
+    int maxPieces = 0; // nothing with more pieces than this is in the table
+
+    uint64_t bishopsOnly = 0; // key of one bishop each and nothing else
+
+    Endgames() {
+        add("KPK", evaluateKPK);
+        add("KBNK", evaluateKBNK);
+        add("KQK", evaluateKXK);
+        add("KRK", evaluateKXK);
+        add("KNNK", evaluateKNNK);
+        addScale("KRKR", scaleKRKR);
+        bishopsOnly = materialKey("KBKB", Color::WHITE);
+    }
+
+    void add(const std::string& code, EndgameFunction function) {
+        table[materialKey(code, Color::WHITE)] = {function, nullptr, Color::WHITE};
+        table[materialKey(code, Color::BLACK)] = {function, nullptr, Color::BLACK};
+        maxPieces = std::max(maxPieces, static_cast<int>(code.size()));
+    }
+
+    void addScale(const std::string& code, ScaleFunction scale) {
+        table[materialKey(code, Color::WHITE)] = {nullptr, scale, Color::WHITE};
+        table[materialKey(code, Color::BLACK)] = {nullptr, scale, Color::BLACK};
+        maxPieces = std::max(maxPieces, static_cast<int>(code.size()));
+    }
+
+    // pawns don't change the key check, so this covers every pawn count at once
+    bool isOppositeBishops(const Board& board, uint64_t key) const {
+        return (key & PIECES_MASK) == bishopsOnly
+            && !utils::sameColor(builtin::lsb(board.pieces(PieceType::BISHOP, Color::WHITE)),
+                                 builtin::lsb(board.pieces(PieceType::BISHOP, Color::BLACK)));
+    }
+
+    // KXK isn't one material key, it covers everything that can mate a bare king
+    // (a queen, a rook, bishops on both colors or a bishop and a knight, pawns alone are left to the search)
+    EndgameFunction bareKing(const Board& board, Color& strong) const {
+        for (int c = 0; c < 2; c++) {
+            const Color weak = Color(1 - c);
+            if (board.us(weak) != board.pieces(PieceType::KING, weak)) {
+                continue;
+            }
+            strong = Color(c);
+            const Bitboard darkSquares = 0xAA55AA55AA55AA55ULL;
+            const Bitboard bishops = board.pieces(PieceType::BISHOP, strong);
+            const bool bishopPair = (bishops & darkSquares) && (bishops & ~darkSquares);
+            if (board.pieces(PieceType::QUEEN, strong) || board.pieces(PieceType::ROOK, strong)
+                || bishopPair || (bishops && board.pieces(PieceType::KNIGHT, strong))) {
+                return evaluateKXK;
+            }
+        }
+        return nullptr;
+    }
+};
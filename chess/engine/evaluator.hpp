@@ -16,6 +16,8 @@
 #include "chess.hpp"
 #include "feature_extractor.hpp"
 #include "baselines.hpp" 
+#include "attack_info.hpp"
+#include "endgame.hpp"
 #pragma once
 
 using namespace chess;
@@ -26,6 +28,35 @@ using namespace builtin;
 
 // these are my human guesstimates or taken from the classic PeSTO engine
 
+// the evaluation is linear in the weights, so a position boils down to a list of feature counts
+// (white minus black, signed the way they are added up), and the weights can be applied later
+// this is what lets the tuner extract features once and then score them against many candidates
+struct EvalFeatures {
+    static const int MATERIAL = 5; // pawn to queen
+    static const int TERMS = 25; // everything else, in the order evaluate adds them up
+
+    int material[MATERIAL]{};
+    int terms[TERMS]{};
+    float gamePhase = 0; // 1 in the opening, 0 in the endgame
+    bool specialized = false; // a specialized endgame scores this position, so the weights don't matter
+    float scale = 1; // what the weighted sum gets multiplied with, below 1 in drawish endgames like KRKR
+};
+
+// which TunableEval weight goes with each count (king pressure shows up once for each king)
+static GamePhaseValue TunableEval::* const MATERIAL_WEIGHTS[EvalFeatures::MATERIAL] = {
+    &TunableEval::pawn, &TunableEval::knight, &TunableEval::bishop, &TunableEval::rook, &TunableEval::queen,
+};
+static GamePhaseValue TunableEval::* const TERM_WEIGHTS[EvalFeatures::TERMS] = {
+    &TunableEval::passedPawn, &TunableEval::doubledPawn, &TunableEval::isolatedPawn, &TunableEval::weakPawn,
+    &TunableEval::centralPawn, &TunableEval::weakSquare, &TunableEval::passedPawnEnemyKingSquare,
+    &TunableEval::knightOutposts, &TunableEval::knightMobility, &TunableEval::bishopMobility, &TunableEval::bishopPair,
+    &TunableEval::rookAttackKingFile, &TunableEval::rookAttackKingAdjFile, &TunableEval::rook7thRank,
+    &TunableEval::rookConnected, &TunableEval::rookMobility, &TunableEval::rookBehindPassedPawn,
+    &TunableEval::rookOpenFile, &TunableEval::rookSemiOpenFile, &TunableEval::rookAtckWeakPawnOpenColumn,
+    &TunableEval::queenMobility, &TunableEval::kingFriendlyPawn, &TunableEval::kingNoEnemyPawnNear,
+    &TunableEval::kingPressureScore, &TunableEval::kingPressureScore,
+};
+
 class Evaluator {
 
 
@@ -51,136 +82,133 @@ class Evaluator {
 
         //heavily influenced by the Raphael engine's implementation
         float evaluate(bool lazy = false){
+            // the phase first, qsearch reads it for delta pruning even when an endgame answers
+            EvalFeatures f;
+            materialFeatures(f);
+            gamePhase = f.gamePhase;
+            EndgameScore endgame;
+            float scale;
+            if (Endgames::instance().probe(board, endgame, scale)){
+                return endgame.score;
+            }
+            if(lazy){
+                return score(f, lazy) * scale;
+            }
+            AttackInfo info;
+            info.compute(board);
+            positionalFeatures(f, info);
+            return score(f, lazy) * scale;
+        }
 
-        //bitboards we need
+        // same as above, but reuses attack sets the search already has for this position
+        float evaluate(const AttackInfo& info){
+            EvalFeatures f;
+            materialFeatures(f);
+            gamePhase = f.gamePhase;
+            EndgameScore endgame;
+            float scale;
+            if (Endgames::instance().probe(board, endgame, scale)){
+                return endgame.score;
+            }
+            positionalFeatures(f, info);
+            return score(f, false) * scale;
+        }
 
-        Bitboard pieces = board.occ();
-        Bitboard wPawns = 0;
-        Bitboard bPawns = 0;
-        Bitboard wKnights = 0;
-        Bitboard bKnights = 0;
-        Bitboard wBishops = 0;
-        Bitboard bBishops = 0;
-        Bitboard wRooks = 0;
-        Bitboard bRooks = 0;
-        Bitboard wQueens = 0;
-        Bitboard bQueens = 0;
-        Bitboard wKings = 0; // these are bitboards even though there can only be one
-        Bitboard bKings = 0;
+        // the unweighted feature counts of the current position
+        // (always the general evaluation, the specialized endgames aren't linear in the weights,
+        // so positions they score are only flagged)
+        EvalFeatures features(){
+            EvalFeatures f;
+            EndgameScore endgame;
+            f.specialized = Endgames::instance().probe(board, endgame, f.scale);
+            materialFeatures(f);
+            AttackInfo info;
+            info.compute(board);
+            positionalFeatures(f, info);
+            return f;
+        }
 
-        //useful bitboards for pawn structure and the like
-        Bitboard wPawnAttacks = 0;
-        Bitboard bPawnAttacks = 0;
+    private:
+        TunableEval featureWeights;
+        float gamePhase;
+        Board& board;
 
-        Bitboard wKnightAttacks = 0;
-        Bitboard bKnightAttacks = 0;
+        // applies the weights, in the same order the features used to be added up one by one
+        // if lazy evaluation is enabled, only material counts
+        float score(const EvalFeatures& f, bool lazy){
+            int mgscore = 0;
+            int egscore = 0;
+            for (int i = 0; i < EvalFeatures::MATERIAL; i++){
+                const GamePhaseValue& weight = featureWeights.*MATERIAL_WEIGHTS[i];
+                mgscore += f.material[i] * weight.middleGame;
+                egscore += f.material[i] * weight.endGame;
+            }
 
-        Bitboard wBishopAttacks = 0;
-        Bitboard bBishopAttacks = 0;
+            gamePhase = f.gamePhase;
+            float mgWeight = gamePhase;
+            float egWeight = 1 - gamePhase;
 
-        Bitboard wRookAttacks = 0;
-        Bitboard bRookAttacks = 0;
+            // Combine middle game and end game scores based on the current game phase
+            float score = mgscore * mgWeight + egscore * egWeight;
+            if(lazy){
+                return score;
+            }
 
-        Bitboard wQueenAttacks = 0;
-        Bitboard bQueenAttacks = 0;
+            for (int i = 0; i < EvalFeatures::TERMS; i++){
+                const GamePhaseValue& weight = featureWeights.*TERM_WEIGHTS[i];
+                score += f.terms[i] * (weight.middleGame * mgWeight + weight.endGame * egWeight);
+            }
+            return score;
+        }
 
-        
-        // variables we need throughout the function
-        float score = 0;
-        int taperedEndgameScore = 0; 
-        int mgscore = 0;
-        int egscore = 0;
-
-
-        // main eval loop
-        for (int i = 0; i < 64; i++){
-            Square sq = int_to_square(i);
-            int sqi = i; // for the piece tables
-            Piece piece = board.at(sq);
-
-            // switch to handle each type of piece
-            switch(piece){
-                case Piece::NONE:
-                    break;
-                case Piece::WHITEPAWN:
-                    wPawns |= square_to_bitmap(sq);
-                    wPawnAttacks |= attacks::pawn(Color::WHITE, sq);
-                    taperedEndgameScore += 1;
-                    mgscore += featureWeights.pawn.middleGame;
-                    egscore += featureWeights.pawn.endGame;
-                    break;
-                case Piece::BLACKPAWN:
-                    bPawns |= square_to_bitmap(sq);
-                    bPawnAttacks |= attacks::pawn(Color::BLACK, sq);
-                    taperedEndgameScore += 1;
-                    mgscore -= featureWeights.pawn.middleGame;
-                    egscore -= featureWeights.pawn.endGame;
-                    break;
-                case Piece::WHITEKNIGHT:
-                    wKnights |= square_to_bitmap(sq);
-                    taperedEndgameScore += 3;
-                    wKnightAttacks |= attacks::knight(sq);
-                    mgscore += featureWeights.knight.middleGame;
-                    egscore += featureWeights.knight.endGame;
-                    break;
-                case Piece::BLACKKNIGHT:
-                    bKnights |= square_to_bitmap(sq);
-                    taperedEndgameScore += 3;
-                    bKnightAttacks |= attacks::knight(sq);
-                    mgscore -= featureWeights.knight.middleGame;
-                    egscore -= featureWeights.knight.endGame;
-                    break;
-                case Piece::WHITEBISHOP:
-                    wBishops |= square_to_bitmap(sq);
-                    taperedEndgameScore += 3;
-                    wBishopAttacks |= attacks::bishop(sq, pieces);
-                    mgscore += featureWeights.bishop.middleGame;
-                    egscore += featureWeights.bishop.endGame;
-                    break;
-                case Piece::BLACKBISHOP:
-                    bBishops |= square_to_bitmap(sq);
-                    taperedEndgameScore += 3;
-                    bBishopAttacks |= attacks::bishop(sq, pieces);
-                    mgscore -= featureWeights.bishop.middleGame;
-                    egscore -= featureWeights.bishop.endGame;
-                    break;
-                case Piece::WHITEROOK:
-                    wRooks |= square_to_bitmap(sq);
-                    taperedEndgameScore += 5;
-                    wRookAttacks |= attacks::rook(sq, pieces);
-                    mgscore += featureWeights.rook.middleGame;
-                    egscore += featureWeights.rook.endGame;
-                    break;
-                case Piece::BLACKROOK:
-                    bRooks |= square_to_bitmap(sq);
-                    taperedEndgameScore += 5;
-                    bRookAttacks |= attacks::rook(sq, pieces);
-                    mgscore -= featureWeights.rook.middleGame;
-                    egscore -= featureWeights.rook.endGame;
-                    break;
-                case Piece::WHITEQUEEN:
-                    wQueens |= square_to_bitmap(sq);
-                    taperedEndgameScore += 9;
-                    wQueenAttacks |= attacks::queen(sq, pieces);
-                    mgscore += featureWeights.queen.middleGame;
-                    egscore += featureWeights.queen.endGame;
-                    break;
-                case Piece::BLACKQUEEN:
-                    bQueens |= square_to_bitmap(sq);
-                    taperedEndgameScore += 9;
-                    bQueenAttacks |= attacks::queen(sq, pieces);
-                    mgscore -= featureWeights.queen.middleGame;
-                    egscore -= featureWeights.queen.endGame;
-                    break;
-                case Piece::WHITEKING:
-                    wKings |= square_to_bitmap(sq);
-                    break;
-                case Piece::BLACKKING:
-                    bKings |= square_to_bitmap(sq);
-                    break;
+        void materialFeatures(EvalFeatures& f){
+            const int phaseWeights[EvalFeatures::MATERIAL] = {1, 3, 3, 5, 9};
+            int taperedEndgameScore = 0;
+            for (int pt = 0; pt < EvalFeatures::MATERIAL; pt++){
+                int white = builtin::popcount(board.pieces(PieceType(pt), Color::WHITE));
+                int black = builtin::popcount(board.pieces(PieceType(pt), Color::BLACK));
+                taperedEndgameScore += (white + black) * phaseWeights[pt];
+                f.material[pt] = white - black;
             }
+
+            // Calculate the game phase dynamically based on the endgame score
+            f.gamePhase = std::max(0.0f, std::min(1.0f, (taperedEndgameScore - 24) / 24.0f)); // Ensure the game phase is between 0 and 1
         }
 
+        void positionalFeatures(EvalFeatures& f, const AttackInfo& info){
+
+        //bitboards we need
+
+        Bitboard pieces = board.occ();
+        Bitboard wPawns = board.pieces(PieceType::PAWN, Color::WHITE);
+        Bitboard bPawns = board.pieces(PieceType::PAWN, Color::BLACK);
+        Bitboard wKnights = board.pieces(PieceType::KNIGHT, Color::WHITE);
+        Bitboard bKnights = board.pieces(PieceType::KNIGHT, Color::BLACK);
+        Bitboard wBishops = board.pieces(PieceType::BISHOP, Color::WHITE);
+        Bitboard bBishops = board.pieces(PieceType::BISHOP, Color::BLACK);
+        Bitboard wRooks = board.pieces(PieceType::ROOK, Color::WHITE);
+        Bitboard bRooks = board.pieces(PieceType::ROOK, Color::BLACK);
+        Bitboard wQueens = board.pieces(PieceType::QUEEN, Color::WHITE);
+        Bitboard bQueens = board.pieces(PieceType::QUEEN, Color::BLACK);
+        Bitboard wKings = board.pieces(PieceType::KING, Color::WHITE); // these are bitboards even though there can only be one
+        Bitboard bKings = board.pieces(PieceType::KING, Color::BLACK);
+
+        //useful bitboards for pawn structure and the like
+        Bitboard wPawnAttacks = info.attacks[0][0];
+        Bitboard bPawnAttacks = info.attacks[1][0];
+
+        Bitboard wKnightAttacks = info.attacks[0][1];
+        Bitboard bKnightAttacks = info.attacks[1][1];
+
+        Bitboard wBishopAttacks = info.attacks[0][2];
+        Bitboard bBishopAttacks = info.attacks[1][2];
+
+        Bitboard wRookAttacks = info.attacks[0][3];
+        Bitboard bRookAttacks = info.attacks[1][3];
+
+        Bitboard wQueenAttacks = info.attacks[0][4];
+        Bitboard bQueenAttacks = info.attacks[1][4];
+
         // more precise attack bitboards
         Bitboard allBPieces = bPawns | bKnights | bBishops | bRooks | bQueens | bKings;
         Bitboard allWPieces = wPawns | wKnights | wBishops | wRooks | wQueens | wKings;
@@ -199,38 +227,22 @@ class Evaluator {
         wQueenAttacks &= ~allWPieces;
         bQueenAttacks &= ~allBPieces;
 
-        
-        // Calculate the game phase dynamically based on the endgame score
-        gamePhase = std::max(0.0f, std::min(1.0f, (taperedEndgameScore - 24) / 24.0f)); // Ensure the game phase is between 0 and 1
-        
-        float mgWeight = gamePhase;
-        float egWeight = 1 - gamePhase;
-        
-        // Combine middle game and end game scores based on the current game phase
-        score = mgscore * mgWeight + egscore * egWeight;
-
-        // if lazy evaluation is enabled, return the score here
-        // we can also be lazy in evaluating completely winning positions not in the endgame
-        if(lazy){
-            return score;
-        }
-
         // extract the rest of the features from the board
 
         // passed pawns (tested and working)
         Bitboard whitePassedPawns = detectPassedPawns(Color::WHITE, wPawns, bPawns);
         Bitboard blackPassedPawns = detectPassedPawns(Color::BLACK, bPawns, wPawns);
-        score += (builtin::popcount(whitePassedPawns) - builtin::popcount(blackPassedPawns)) * (featureWeights.passedPawn.middleGame * mgWeight + featureWeights.passedPawn.endGame * egWeight);
+        f.terms[0] = (builtin::popcount(whitePassedPawns) - builtin::popcount(blackPassedPawns));
 
         // doubled pawns (tested and working)
         // adjusting the score negatively for doubled pawns
-        score -= (detectDoubledPawns(Color::BLACK, wPawns, bPawns) - detectDoubledPawns(Color::WHITE, bPawns, wPawns)) * (featureWeights.doubledPawn.middleGame * mgWeight + featureWeights.doubledPawn.endGame * egWeight);
+        f.terms[1] = -(detectDoubledPawns(Color::BLACK, wPawns, bPawns) - detectDoubledPawns(Color::WHITE, bPawns, wPawns));
 
         Bitboard isolatedWhitePawns = detectIsolatedPawns(wPawns);
         Bitboard isolatedBlackPawns = detectIsolatedPawns(bPawns);
         // isolated pawns (tested and working)
         // adjusting the score negatively for isolated pawns
-        score -= (builtin::popcount(isolatedWhitePawns) - builtin::popcount(isolatedBlackPawns)) * (featureWeights.isolatedPawn.middleGame * mgWeight + featureWeights.isolatedPawn.endGame * egWeight);
+        f.terms[2] = -(builtin::popcount(isolatedWhitePawns) - builtin::popcount(isolatedBlackPawns));
 
 
         // weak pawns (finally working)
@@ -242,87 +254,81 @@ class Evaluator {
         weakWhitePawns &= ~whitePassedPawns & ~isolatedWhitePawns;
         weakBlackPawns &= ~blackPassedPawns & ~isolatedBlackPawns;
 
-        score -= (builtin::popcount(weakBlackPawns) - builtin::popcount(weakWhitePawns)) * (featureWeights.weakPawn.middleGame * mgWeight + featureWeights.weakPawn.endGame * egWeight);
+        f.terms[3] = -(builtin::popcount(weakBlackPawns) - builtin::popcount(weakWhitePawns));
 
         // central pawns (not tested)
-        score += (builtin::popcount(detectCentralPawns(wPawns)) - builtin::popcount(detectCentralPawns(bPawns))) * (featureWeights.centralPawn.middleGame * mgWeight + featureWeights.centralPawn.endGame * egWeight);
+        f.terms[4] = (builtin::popcount(detectCentralPawns(wPawns)) - builtin::popcount(detectCentralPawns(bPawns)));
 
         // weak squares (working finally)
         // adjusting the score negatively for weak squares
         Bitboard weakWhiteSquares = detectWeakSquares(Color::WHITE, wPawns);
         Bitboard weakBlackSquares = detectWeakSquares(Color::BLACK, bPawns);
-        score -= (builtin::popcount(weakBlackSquares) - builtin::popcount(weakWhiteSquares)) * (featureWeights.weakSquare.middleGame * mgWeight + featureWeights.weakSquare.endGame * egWeight);
+        f.terms[5] = -(builtin::popcount(weakBlackSquares) - builtin::popcount(weakWhiteSquares));
 
         // rule of the square (tested and working)
-        score += (ruleOfTheSquare(Color::WHITE, blackPassedPawns, wKings) - ruleOfTheSquare(Color::BLACK, whitePassedPawns, bKings)) * (featureWeights.passedPawnEnemyKingSquare.middleGame * mgWeight + featureWeights.passedPawnEnemyKingSquare.endGame * egWeight);
+        f.terms[6] = (ruleOfTheSquare(Color::WHITE, blackPassedPawns, wKings) - ruleOfTheSquare(Color::BLACK, whitePassedPawns, bKings));
         
         // knight outposts (tested like 90% sure it works)
-        score += (builtin::popcount(knightOutposts(weakBlackSquares, wKnights, wPawnAttacks)) - builtin::popcount(knightOutposts(weakWhiteSquares, bKnights, bPawnAttacks))) * (featureWeights.knightOutposts.middleGame * mgWeight + featureWeights.knightOutposts.endGame * egWeight);
+        f.terms[7] = (builtin::popcount(knightOutposts(weakBlackSquares, wKnights, wPawnAttacks)) - builtin::popcount(knightOutposts(weakWhiteSquares, bKnights, bPawnAttacks)));
 
         // knight mobility (not tested)
-        score += (knightMobility(wKnightAttacks) - knightMobility(bKnightAttacks)) * (featureWeights.knightMobility.middleGame * mgWeight + featureWeights.knightMobility.endGame * egWeight);
+        f.terms[8] = (knightMobility(wKnightAttacks) - knightMobility(bKnightAttacks));
 
         // bishop mobility (tested)
-        score += (bishopMobility(wBishopAttacks) - bishopMobility(bBishopAttacks)) * (featureWeights.bishopMobility.middleGame * mgWeight + featureWeights.bishopMobility.endGame * egWeight);
+        f.terms[9] = (bishopMobility(wBishopAttacks) - bishopMobility(bBishopAttacks));
         
 
         // bishop pair (tested and working)
-        score += (bishopPair(wBishops) - bishopPair(bBishops)) * (featureWeights.bishopPair.middleGame * mgWeight + featureWeights.bishopPair.endGame * egWeight);
+        f.terms[10] = (bishopPair(wBishops) - bishopPair(bBishops));
         
 
         // rook attack king file (tested and fixed)
-        score += (rookAttackKingFile(Color::WHITE, wRooks, bKings) - rookAttackKingFile(Color::BLACK, bRooks, wKings)) * (featureWeights.rookAttackKingFile.middleGame * mgWeight + featureWeights.rookAttackKingFile.endGame * egWeight);
+        f.terms[11] = (rookAttackKingFile(Color::WHITE, wRooks, bKings) - rookAttackKingFile(Color::BLACK, bRooks, wKings));
 
         // rook attack king adjacent file (tested and fixed)
-        score += (rookAttackKingAdjFile(Color::WHITE, wRooks, bKings) - rookAttackKingAdjFile(Color::BLACK, bRooks, wKings)) * (featureWeights.rookAttackKingAdjFile.middleGame * mgWeight + featureWeights.rookAttackKingAdjFile.endGame * egWeight);
+        f.terms[12] = (rookAttackKingAdjFile(Color::WHITE, wRooks, bKings) - rookAttackKingAdjFile(Color::BLACK, bRooks, wKings));
 
 
         // rook on 7th rank (tested and working)
-        score += (rookSeventhRank(Color::WHITE, wRooks) - rookSeventhRank(Color::BLACK, bRooks)) * (featureWeights.rook7thRank.middleGame * mgWeight + featureWeights.rook7thRank.endGame * egWeight);
+        f.terms[13] = (rookSeventhRank(Color::WHITE, wRooks) - rookSeventhRank(Color::BLACK, bRooks));
         
 
         // rook connected (tested and working)
-        score += (rookConnected(Color::WHITE, wRooks, pieces) - rookConnected(Color::BLACK, bRooks, pieces)) * (featureWeights.rookConnected.middleGame * mgWeight + featureWeights.rookConnected.endGame * egWeight);
+        f.terms[14] = (rookConnected(Color::WHITE, wRooks, pieces) - rookConnected(Color::BLACK, bRooks, pieces));
         
 
         // rook mobility (tested and working)
-        score += (rookMobility(wRookAttacks) - rookMobility(bRookAttacks)) * (featureWeights.rookMobility.middleGame * mgWeight + featureWeights.rookMobility.endGame * egWeight);
+        f.terms[15] = (rookMobility(wRookAttacks) - rookMobility(bRookAttacks));
 
 
         // rook behind passed pawn (tested and working) 
-        score += (rookBehindPassedPawn(Color::WHITE, wRooks, whitePassedPawns) - rookBehindPassedPawn(Color::BLACK, bRooks, blackPassedPawns)) * (featureWeights.rookBehindPassedPawn.middleGame * mgWeight + featureWeights.rookBehindPassedPawn.endGame * egWeight);
+        f.terms[16] = (rookBehindPassedPawn(Color::WHITE, wRooks, whitePassedPawns) - rookBehindPassedPawn(Color::BLACK, bRooks, blackPassedPawns));
         
 
         // rook on open file
         Bitboard allPawns = wPawns | bPawns;
-        score += (rookOpenFile(Color::WHITE, wRooks, allPawns) - rookOpenFile(Color::BLACK, bRooks, allPawns)) * (featureWeights.rookOpenFile.middleGame * mgWeight + featureWeights.rookOpenFile.endGame * egWeight);
+        f.terms[17] = (rookOpenFile(Color::WHITE, wRooks, allPawns) - rookOpenFile(Color::BLACK, bRooks, allPawns));
 
         // rook on semi-open file
-        score += (rookSemiOpenFile(Color::WHITE, wRooks, wPawns, bPawns) - rookSemiOpenFile(Color::BLACK, bRooks, bPawns, wPawns)) * (featureWeights.rookSemiOpenFile.middleGame * mgWeight + featureWeights.rookSemiOpenFile.endGame * egWeight);
+        f.terms[18] = (rookSemiOpenFile(Color::WHITE, wRooks, wPawns, bPawns) - rookSemiOpenFile(Color::BLACK, bRooks, bPawns, wPawns));
 
         // rook attack weak pawn on open column
-        score += (rookAtckWeakPawnOpenColumn(Color::WHITE, wRooks, weakBlackPawns) - rookAtckWeakPawnOpenColumn(Color::BLACK, bRooks, weakWhitePawns)) * (featureWeights.rookAtckWeakPawnOpenColumn.middleGame * mgWeight + featureWeights.rookAtckWeakPawnOpenColumn.endGame * egWeight);
+        f.terms[19] = (rookAtckWeakPawnOpenColumn(Color::WHITE, wRooks, weakBlackPawns) - rookAtckWeakPawnOpenColumn(Color::BLACK, bRooks, weakWhitePawns));
 
         // queen mobility (not tested)
-        score += (queenMobility(wQueenAttacks) - queenMobility(bQueenAttacks)) * (featureWeights.queenMobility.middleGame * mgWeight + featureWeights.queenMobility.endGame * egWeight);
+        f.terms[20] = (queenMobility(wQueenAttacks) - queenMobility(bQueenAttacks));
 
         // king friendly pawn
-        score += (kingFriendlyPawn(wPawns, wKings) - kingFriendlyPawn(bPawns, bKings)) * (featureWeights.kingFriendlyPawn.middleGame * mgWeight + featureWeights.kingFriendlyPawn.endGame * egWeight);
+        f.terms[21] = (kingFriendlyPawn(wPawns, wKings) - kingFriendlyPawn(bPawns, bKings));
 
         // king no enemy pawn near
-        score += (kingNoEnemyPawnNear(bPawns, wKings) - kingNoEnemyPawnNear(wPawns, bKings)) * (featureWeights.kingNoEnemyPawnNear.middleGame * mgWeight + featureWeights.kingNoEnemyPawnNear.endGame * egWeight);
+        f.terms[22] = (kingNoEnemyPawnNear(bPawns, wKings) - kingNoEnemyPawnNear(wPawns, bKings));
 
         // revised king pressure scores  (yet to be tested)
-        score -= kingPressureScore(wKings, bKnightAttacks, bBishopAttacks, bRookAttacks, bQueenAttacks, Color::BLACK, board) * (featureWeights.kingPressureScore.middleGame * mgWeight + featureWeights.kingPressureScore.endGame * egWeight);
-        score += kingPressureScore(bKings, wKnightAttacks, wBishopAttacks, wRookAttacks, wQueenAttacks, Color::WHITE, board) * (featureWeights.kingPressureScore.middleGame * mgWeight + featureWeights.kingPressureScore.endGame * egWeight);
-        return score;
+        f.terms[23] = -(kingPressureScore(info.kingZone[0], bKnightAttacks, bBishopAttacks, bRookAttacks, bQueenAttacks));
+        f.terms[24] = kingPressureScore(info.kingZone[1], wKnightAttacks, wBishopAttacks, wRookAttacks, wQueenAttacks);
         }
 
-    private:
-        TunableEval featureWeights;
-        float gamePhase;
-        Board& board;
-
         // added some inline stuff to hopefully speed it up
         constexpr inline static Color color(Piece piece) {
             return static_cast<Color>(static_cast<int>(piece) / 6);
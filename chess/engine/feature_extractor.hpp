@@ -669,9 +669,9 @@ Bitboard calculateKingsZone(const Bitboard& kingPosition, Color color) {
 }
 
 
-int kingPressureScore(const Bitboard& king, const Bitboard& enemyKnights, const Bitboard& enemyBishops, const Bitboard& enemyRooks, const Bitboard& enemyQueens, Color color, const Board& board) {
+// same weighting, for when the king zone is already known (the evaluator gets it from AttackInfo)
+int kingPressureScore(const Bitboard& kingZone, const Bitboard& enemyKnights, const Bitboard& enemyBishops, const Bitboard& enemyRooks, const Bitboard& enemyQueens) {
     int score = 0;
-    Bitboard kingZone = calculateKingsZone(king, color); // Assume a function similar to calculateKingsZone but more nuanced
 
     // Factor in different piece types with tailored evaluations
     score += builtin::popcount(kingZone & enemyKnights) * 1;
@@ -682,6 +682,11 @@ int kingPressureScore(const Bitboard& king, const Bitboard& enemyKnights, const
     return score;
 }
 
+int kingPressureScore(const Bitboard& king, const Bitboard& enemyKnights, const Bitboard& enemyBishops, const Bitboard& enemyRooks, const Bitboard& enemyQueens, Color color, const Board& board) {
+    Bitboard kingZone = calculateKingsZone(king, color); // Assume a function similar to calculateKingsZone but more nuanced
+    return kingPressureScore(kingZone, enemyKnights, enemyBishops, enemyRooks, enemyQueens);
+}
+
 
 
 
@@ -83,7 +83,8 @@ public:
         return Move::NULL_MOVE;
     }
 
-    chess::Move pickRandomMove(const Board& board) {
+    // picks one of the book moves for this position with rng, so the same seed always gives the same line
+    chess::Move pickRandomMove(const Board& board, std::mt19937& rng) {
         uint64_t key = board.zobrist();
         std::vector<chess::Move> possibleMoves;
         for (const auto& entry : entries) {
@@ -98,10 +99,8 @@ public:
         if (possibleMoves.empty()) {
             return chess::Move::NULL_MOVE;
         } else {
-            std::random_device rd;
-            std::mt19937 mt(rd());
             std::uniform_int_distribution<size_t> dist(0, possibleMoves.size() - 1);
-            return possibleMoves[dist(mt)];
+            return possibleMoves[dist(rng)];
         }
     }
 };
@@ -0,0 +1,117 @@
+// counters for seeing which parts of the search actually do something
+// only compiled in with -DSEARCH_STATS, otherwise SEARCH_STAT(...) expands to nothing
+// so the normal engine pays nothing for it
+#pragma once
+#include <ostream>
+#include <vector>
+
+#ifdef SEARCH_STATS
+#define SEARCH_STAT(x) do { stats.x; } while (0)
+#else
+#define SEARCH_STAT(x) do { } while (0)
+#endif
+
+struct SearchIterationStats {
+    int depth = 0;
+    long nodes = 0; // nodes searched in this iteration only
+    double ebf = 0; // effective branching factor compared to the previous iteration
+};
+
+struct SearchStats {
+    static const int CUTOFF_BUCKETS = 8; // the last bucket is for every move index past 6
+
+    // node counts
+    long mainNodes = 0; // calls to negamax
+    long qNodes = 0; // calls to quiescence
+
+    // transposition table
+    long ttProbes = 0;
+    long ttHits = 0;
+    long ttHitsExact = 0;
+    long ttHitsLower = 0;
+    long ttHitsUpper = 0;
+    long ttCutoffs = 0;
+    long tbHits = 0; // syzygy probes that returned a result
+
+    // move ordering
+    long betaCutoffs = 0;
+    long cutoffsByMoveIndex[CUTOFF_BUCKETS]{};
+
+    // pruning and reductions
+    long rfpCutoffs = 0;
+    long nmpTries = 0;
+    long nmpCutoffs = 0;
+    long razorTries = 0;
+    long razorCutoffs = 0;
+    long probCutTries = 0;
+    long probCutCutoffs = 0;
+    long iidSearches = 0;
+    long iirReductions = 0;
+    long lmpPrunes = 0;
+    long lmrReductions = 0;
+    long lmrReSearches = 0;
+    long pvsReSearches = 0;
+    long deltaPrunes = 0;
+    long aspirationFails = 0;
+
+    std::vector<SearchIterationStats> iterations;
+
+    void reset() {
+        *this = SearchStats();
+    }
+
+    void cutoffAt(int moveIndex) {
+        betaCutoffs++;
+        cutoffsByMoveIndex[moveIndex < CUTOFF_BUCKETS - 1 ? moveIndex : CUTOFF_BUCKETS - 1]++;
+    }
+
+    // called after each finished iteration with the total node count so far
+    void endIteration(int depth, long totalNodes) {
+        long previousTotal = 0;
+        for (const SearchIterationStats& it : iterations) {
+            previousTotal += it.nodes;
+        }
+        SearchIterationStats it;
+        it.depth = depth;
+        it.nodes = totalNodes - previousTotal;
+        if (!iterations.empty() && iterations.back().nodes > 0) {
+            it.ebf = double(it.nodes) / double(iterations.back().nodes);
+        }
+        iterations.push_back(it);
+    }
+
+    double firstMoveCutoffRate() const {
+        return betaCutoffs ? double(cutoffsByMoveIndex[0]) / double(betaCutoffs) : 0;
+    }
+
+    // one json object, so a tuning script can parse it straight from stderr
+    void writeJson(std::ostream& out) const {
+        out << "{";
+        out << "\"mainNodes\":" << mainNodes << ",\"qNodes\":" << qNodes;
+        out << ",\"tt\":{\"probes\":" << ttProbes << ",\"hits\":" << ttHits
+            << ",\"exact\":" << ttHitsExact << ",\"lower\":" << ttHitsLower << ",\"upper\":" << ttHitsUpper
+            << ",\"cutoffs\":" << ttCutoffs << "}";
+        out << ",\"tbHits\":" << tbHits;
+        out << ",\"betaCutoffs\":" << betaCutoffs << ",\"firstMoveCutoffRate\":" << firstMoveCutoffRate();
+        out << ",\"cutoffsByMoveIndex\":[";
+        for (int i = 0; i < CUTOFF_BUCKETS; i++) {
+            out << (i ? "," : "") << cutoffsByMoveIndex[i];
+        }
+        out << "]";
+        out << ",\"rfp\":{\"cutoffs\":" << rfpCutoffs << "}";
+        out << ",\"nmp\":{\"tries\":" << nmpTries << ",\"cutoffs\":" << nmpCutoffs << "}";
+        out << ",\"razoring\":{\"tries\":" << razorTries << ",\"cutoffs\":" << razorCutoffs << "}";
+        out << ",\"probCut\":{\"tries\":" << probCutTries << ",\"cutoffs\":" << probCutCutoffs << "}";
+        out << ",\"iid\":{\"searches\":" << iidSearches << "},\"iir\":{\"reductions\":" << iirReductions << "}";
+        out << ",\"lmp\":{\"prunes\":" << lmpPrunes << "}";
+        out << ",\"lmr\":{\"reductions\":" << lmrReductions << ",\"reSearches\":" << lmrReSearches << "}";
+        out << ",\"pvsReSearches\":" << pvsReSearches << ",\"deltaPrunes\":" << deltaPrunes;
+        out << ",\"aspirationFails\":" << aspirationFails;
+        out << ",\"iterations\":[";
+        for (size_t i = 0; i < iterations.size(); i++) {
+            out << (i ? "," : "") << "{\"depth\":" << iterations[i].depth << ",\"nodes\":" << iterations[i].nodes
+                << ",\"ebf\":" << iterations[i].ebf << "}";
+        }
+        out << "]}";
+    }
+};
@@ -1,10 +1,18 @@
 #include "chess.hpp"
 #include "baselines.hpp"
 #include "evaluator.hpp"
+#include "attack_info.hpp"
 #include "t_table.hpp"
+#include "search_stats.hpp"
+#include "syzygy.hpp"
 #include "math.h"
 #include <chrono>
 #include <map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 using namespace chess;
 using namespace std;
@@ -37,14 +45,18 @@ struct SearchState {
 
 class Searcher2 {
     public:
-    Searcher2(Board& initialBoard, TunableSearch& searchParams = baseSearch, TunableEval& evalParams = baseEval)
-    : board(initialBoard), searchParams(searchParams), evalParams(evalParams), evaluator(board, evalParams), tt(2 << 22){
+    static const size_t DEFAULT_TT_ENTRIES = 2 << 22;
+
+    Searcher2(Board& initialBoard, const TunableSearch& searchParams = baseSearch, const TunableEval& evalParams = baseEval, size_t ttEntries = DEFAULT_TT_ENTRIES)
+    : board(initialBoard), searchParams(searchParams), evalParams(evalParams), evaluator(board, evalParams), tt(ttEntries){
         searchState = SearchState();
     }
 
-    void initSearchState(){
-        stopSearching = false;
+    ~Searcher2() {
+        stopTimer();
+    }
 
+    void initSearchState(){
         //searchState.isOpening = true;
         searchState.bestMove = Move::NO_MOVE;
         searchState.currentDepth = 1;
@@ -72,14 +84,60 @@ class Searcher2 {
         piece_values[1][6] = 0; // for empty square
     }
 
+    // ends the current search as soon as possible (safe to call from another thread)
+    void stop(){
+        stopSearching.store(true, std::memory_order_relaxed);
+    }
+
+    // forgets a stop that came in while no search was running
+    // the uci thread calls this before it starts the search thread, so a stop sent right after go
+    // (before the search got going) still ends that search instead of being cleared by it
+    void resetStop(){
+        stopSearching.store(false, std::memory_order_relaxed);
+    }
+
     void setVerbose(bool v){
         verbose = v;
     }
 
+    // called after every finished depth with the search state and the milliseconds since the start
+    void setIterationCallback(std::function<void(const SearchState&, long)> callback){
+        iterationCallback = std::move(callback);
+    }
+
     void clear(){
         tt.clear();
     }
 
+    // forget everything about the last game, so one searcher can play many (the tt is not reallocated)
+    void newGame(){
+        tt.clear();
+        searchState = SearchState();
+        // move ordering and node types read the pv of the last search, so it has to go too
+        std::fill(&pvTable[0][0], &pvTable[0][0] + (MAXDEPTH + 1) * (MAXDEPTH + 1), Move(Move::NO_MOVE));
+        std::memset(pvLength, 0, sizeof(pvLength));
+    }
+
+    // resizes the transposition table to fit in megabytes, which also empties it
+    void setHashSize(size_t megabytes){
+        tt.resize(TranspositionTable::entriesForMegabytes(megabytes));
+    }
+
+    void setSearchParams(const TunableSearch& params){
+        searchParams = params;
+    }
+
+    void setEvalParams(const TunableEval& params){
+        evalParams = params;
+        evaluator.setFeatureWeights(params);
+    }
+
+#ifdef SEARCH_STATS
+    const SearchStats& getStats() const {
+        return stats;
+    }
+#endif
+
     std::string getPV() {
         return uci::moveToUci(pvTable[0][0]);
     }
@@ -88,12 +146,34 @@ class Searcher2 {
         initSearchState();
         start_t = std::chrono::high_resolution_clock::now();
         timeForThisMove = calculateTimeForMove(timeLeft, timeIncrement, movesToGo);
-        
+        startTimer(timeForThisMove);
+        return deepen(MAXDEPTH, true);
+    }
+
+    // search without time management: stops after maxDepth plies, maxNodes nodes or maxMilliseconds
+    // (0 for no limit on any of them) and plays the best move of the last finished depth
+    // without a time limit the result never depends on machine load
+    SearchState fixedSearch(int maxDepth, long maxNodes, int maxMilliseconds = 0) {
+        initSearchState();
+        nodeLimit = maxNodes;
+        if (maxMilliseconds > 0) {
+            startTimer(maxMilliseconds);
+        }
+        SearchState result = deepen(maxDepth > 0 ? std::min(maxDepth, MAXDEPTH) : MAXDEPTH, false);
+        nodeLimit = 0;
+        return result;
+    }
 
-        for (int depth = 1; depth <= MAXDEPTH; depth++) {
+    private:
+    // iterative deepening up to maxDepth, useClock decides if the time management may end it early
+    SearchState deepen(int maxDepth, bool useClock) {
+        SEARCH_STAT(reset());
+        syzygy::probeRoot(board, tbRootMoves);
+
+        for (int depth = 1; depth <= maxDepth; depth++) {
             int score = neg_infinity;
             
-            if (stopOnThisDepth()) {
+            if (useClock && stopOnThisDepth()) {
                 break;
             }
 
@@ -107,6 +187,7 @@ class Searcher2 {
                 // research on a full window if aspiration search fails
                 // might need to add to the time here
                 if (score <= searchState.aspirationWindow.alpha || score >= searchState.aspirationWindow.beta) {
+                    SEARCH_STAT(aspirationFails++);
                     score = negamax(depth, neg_infinity, infinity, 0);
                 }
 
@@ -117,16 +198,22 @@ class Searcher2 {
             
             
 
-            if (stopSearching) { // don't make updates if we're stopping
+            if (isTimeOver()) { // don't make updates if we're stopping
                 break;
             }
 
             searchState.bestMove = pvTable[0][0];
             searchState.bestScore = score;
+            searchState.currentDepth = depth;
+            SEARCH_STAT(endIteration(depth, searchState.nodes));
 
             auto now = std::chrono::high_resolution_clock::now();
             auto dtime = std::chrono::duration_cast<std::chrono::milliseconds>(now - start_t).count();
 
+            if (iterationCallback){
+                iterationCallback(searchState, dtime);
+            }
+
             if (verbose){
                 std::cout << "info depth " << depth << " score cp " << searchState.bestScore << " nodes " << searchState.nodes   << " nps " << signed((searchState.nodes / (dtime + 1)) * 1000) << " time " << dtime << " pv " << getPV() << std::endl;
             }
@@ -137,23 +224,34 @@ class Searcher2 {
             movegen::legalmoves<MoveGenType::ALL>(moves, board);
             searchState.bestMove = moves[0];
         }
+        stopTimer();
+        resetStop(); // the timer is gone, so the next search starts unstopped
         searchState.numMovesOutofBook ++; // count only moves we've played
+#ifdef SEARCH_STATS
+        stats.writeJson(std::cerr);
+        std::cerr << std::endl;
+#endif
         return searchState;
 
     }
 
-    private:
     Board& board;
-    TunableSearch& searchParams;
-    TunableEval& evalParams;
+    TunableSearch searchParams;
+    TunableEval evalParams;
     Evaluator evaluator;
     TranspositionTable tt;
     SearchState searchState;
+#ifdef SEARCH_STATS
+    SearchStats stats;
+#endif
 
     // for storing the pvs
     Move pvTable[MAXDEPTH + 1][MAXDEPTH + 1]{};
     int pvLength[MAXDEPTH + 1]{};
 
+    // attacks, pins and checks of the position at each ply, shared by eval, SEE and the legality check
+    AttackInfo attackInfo[MAXDEPTH + 1];
+
     int history[2][6][64]; // history heuristic table
     
     
@@ -161,6 +259,9 @@ class Searcher2 {
     const int infinity = 9999999;
     const int neg_infinity = -infinity;
     const int MATE_SCORE = 10000;
+    const int TB_WIN_SCORE = MATE_SCORE - 2 * MAXDEPTH; // below every mate score, so mates are still preferred
+
+    Movelist tbRootMoves; // root moves that keep the tablebase result, empty without a tablebase hit
 
     // for move ordering and piece values
     int piece_values[2][7]{}; // 6 piece types + empty square
@@ -168,21 +269,46 @@ class Searcher2 {
     // for Time Management
     std::chrono::high_resolution_clock::time_point start_t;  // search start time
     int timeForThisMove = 0;
-    bool stopSearching = false;
+    std::atomic<bool> stopSearching{false};
+
+    // a separate thread sleeps until the deadline and then raises stopSearching,
+    // so the search itself never has to read the clock
+    std::thread timerThread;
+    std::mutex timerMutex;
+    std::condition_variable timerCv;
+    bool timerCancelled = false;
 
     bool verbose = true;
+    std::function<void(const SearchState&, long)> iterationCallback;
+
 
+    long nodeLimit = 0; // set by fixedSearch, 0 for none
 
     bool isTimeOver() {
-        // otherwise, check timeover every 2048 nodes
-        if (!(searchState.nodes & 2047)) {
-            auto now = std::chrono::high_resolution_clock::now();
-            auto dtime = std::chrono::duration_cast<std::chrono::milliseconds>(now - start_t).count();
-            if (dtime >= timeForThisMove){
-                stopSearching = true;
+        return stopSearching.load(std::memory_order_relaxed) || (nodeLimit && searchState.nodes >= nodeLimit);
+    }
+
+    void startTimer(int ms) {
+        stopTimer();
+        timerCancelled = false;
+        auto deadline = start_t + std::chrono::milliseconds(ms);
+        timerThread = std::thread([this, deadline]() {
+            std::unique_lock<std::mutex> lock(timerMutex);
+            if (!timerCv.wait_until(lock, deadline, [this]() { return timerCancelled; })) {
+                stopSearching.store(true, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    void stopTimer() {
+        if (timerThread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(timerMutex);
+                timerCancelled = true;
             }
+            timerCv.notify_one();
+            timerThread.join();
         }
-        return stopSearching;
     }
 
     bool stopOnThisDepth() {
@@ -215,11 +341,13 @@ class Searcher2 {
     // add max depth to qs search (15 is small brain's)
 
     int quiescence (int alpha, int beta, int ply){
-        if (isTimeOver() || stopSearching) {
+        if (isTimeOver()) {
             return 0;
         }
 
-        int stand_pat = evaluate(false);
+        SEARCH_STAT(qNodes++);
+        const AttackInfo& info = attackInfoAt(ply);
+        int stand_pat = evaluate(false, info);
         
         if (ply >= MAXDEPTH){
             return stand_pat;
@@ -233,8 +361,9 @@ class Searcher2 {
             alpha = stand_pat;
         }
 
+        // legality is only checked for the captures we actually get to
         Movelist moves;
-        movegen::legalmoves<MoveGenType::CAPTURE>(moves, board);
+        movegen::pseudolegalmoves<MoveGenType::CAPTURE>(moves, board);
 
         scoreMoves(moves, ply);
         sortMoves(moves);
@@ -257,6 +386,11 @@ class Searcher2 {
             bool givesCheck = board.kingSq(board.sideToMove() == Color::WHITE? Color::BLACK : Color::WHITE) == move.to();
 
             if (stand_pat + piece_values[gamePhase][index] + searchParams.deltaMargin < alpha && !isPromotion && !givesCheck && board.hasNonPawnMaterial(board.sideToMove())) {
+                SEARCH_STAT(deltaPrunes++);
+                continue;
+            }
+
+            if (!info.isLegal(board, move)) {
                 continue;
             }
 
@@ -265,7 +399,7 @@ class Searcher2 {
             int score = -quiescence(-beta, -alpha, ply + 1);
             board.unmakeMove(move);
 
-            if (stopSearching) {
+            if (isTimeOver()) {
                 return 0;
             }
 
@@ -288,7 +422,7 @@ class Searcher2 {
 
 
     int negamax(int depth, int alpha, int beta, int ply, bool nullMove = false) {
-        if (isTimeOver() || stopSearching) {
+        if (isTimeOver()) {
             return 0;
         }
         
@@ -297,14 +431,25 @@ class Searcher2 {
             return 0; // Draw score (can add contempt later)
         }
 
+        // endgames we know are drawn (like most of kpk) need no search at all
+        // (the piece count check keeps this off every node that isn't a tiny endgame)
+        const Endgames& endgames = Endgames::instance();
+        EndgameScore endgame;
+        if (ply > 0 && builtin::popcount(board.occ()) <= endgames.maxPieceCount()
+            && endgames.probe(board, endgame) && endgame.draw) {
+            return 0;
+        }
+
         if (depth <= 0 || ply >= MAXDEPTH) {
             return quiescence(alpha, beta, ply); 
         }
+        SEARCH_STAT(mainNodes++);
         
 
         
         bool isRoot = (ply == 0);
-        bool isInCheck = board.inCheck();
+        const AttackInfo& info = attackInfoAt(ply);
+        bool isInCheck = info.inCheck();
         bool isPvs = beta - alpha > 1;
         int  moveCount = 0;
 
@@ -315,25 +460,37 @@ class Searcher2 {
         }
 
         // tt lookup
-        uint64_t zobristKey = board.zobrist();
+        uint64_t zobristKey = board.hash(); // kept up to date by makeMove, zobrist() would recompute it
         optional<TTEntry> ttEntry = tt.retrieve(zobristKey);
         NodeType nodeType = NodeType::UPPERBOUND;
         int best = neg_infinity;
         bool useTT = false;
         Move ttMove = Move::NO_MOVE;
         int ttScore = 0;
+        SEARCH_STAT(ttProbes++);
+
+        // even a shallow entry has a move worth trying first
+        if (ttEntry.has_value()) {
+            ttMove = ttEntry->bestMove;
+            SEARCH_STAT(ttHits++);
+        }
 
         if (ttEntry.has_value() && ttEntry->depth >= depth && !isRoot && !isPvs) {
             if (ttEntry->nodeType == NodeType::EXACT) {
+                SEARCH_STAT(ttHitsExact++);
+                SEARCH_STAT(ttCutoffs++);
                 return ttEntry->score;
             }
             else if (ttEntry->nodeType == NodeType::LOWERBOUND) {
+                SEARCH_STAT(ttHitsLower++);
                 alpha = max(alpha, ttEntry->score);
             }
             else if (ttEntry->nodeType == NodeType::UPPERBOUND) {
+                SEARCH_STAT(ttHitsUpper++);
                 beta = min(beta, ttEntry->score);
             }
             if (alpha >= beta) {
+                SEARCH_STAT(ttCutoffs++);
                 return ttEntry->score;
             }
             ttMove = ttEntry->bestMove;
@@ -341,14 +498,26 @@ class Searcher2 {
             useTT = true;
         }
 
+        // tablebase hit: the exact result, nothing below this node can change it
+        if (!isRoot && syzygy::canProbe(board)) {
+            syzygy::Wdl wdl = syzygy::probeWdl(board);
+            if (wdl != syzygy::Wdl::FAILED) {
+                SEARCH_STAT(tbHits++);
+                int tbScore = wdl == syzygy::Wdl::WIN ? TB_WIN_SCORE - ply : wdl == syzygy::Wdl::LOSS ? -TB_WIN_SCORE + ply : 0;
+                tt.save(zobristKey, MAXDEPTH, tbScore, NodeType::EXACT, Move::NO_MOVE);
+                return tbScore;
+            }
+        }
+
         // lazy eval option (probably bad, but we'll leave it to the tuner)
-        int staticEval = evaluate(searchParams.useLazyEvalStatic);
+        int staticEval = evaluate(searchParams.useLazyEvalStatic, info);
 
         // reverse futility pruning or static null move pruning 
         // conditions: not a null move, not in check, not a pvs search, beta is not a mate score
         if (!isPvs && !isInCheck && (abs(beta) < (MATE_SCORE - MAXDEPTH))){
            int margin = searchParams.futilityMargin * depth * depth;
               if (staticEval - margin >= beta){
+                  SEARCH_STAT(rfpCutoffs++);
                   return staticEval - margin;
               }
         }
@@ -356,7 +525,9 @@ class Searcher2 {
         // null move pruning (we pass Null Move to make sure we don't make double null moves)
         // revisit if time, because I'm not confident in this implementation
         if (!nullMove && !isPvs && !isInCheck && staticEval >= beta && depth >= 3 && board.hasNonPawnMaterial(board.sideToMove())){
+            SEARCH_STAT(nmpTries++);
             board.makeNullMove();
+            tt.prefetch(board.hash());
             // to avoid divide by zero issues in tuner
             // (0 or 1 is unlikely to be the final tuned value)
             if (searchParams.nullMovePruningDepthFactor == 0){
@@ -366,6 +537,7 @@ class Searcher2 {
             int nullMoveScore = -negamax(depth - 1 - r, -beta, -beta + 1, ply + 1, true);
             board.unmakeNullMove();
             if (nullMoveScore >= beta){ // add a small tempo bonus 
+                SEARCH_STAT(nmpCutoffs++);
                 // make sure we don't return a false mate score
                 if (nullMoveScore >= MATE_SCORE - MAXDEPTH){
                     return beta;
@@ -379,37 +551,108 @@ class Searcher2 {
         if (!isPvs && !isInCheck && depth <= 3){
             int margin = searchParams.razoringMargin * depth * depth;
             if (staticEval + margin <= alpha){
+                SEARCH_STAT(razorTries++);
                 int razorScore = quiescence(alpha, beta, ply);
                 if (razorScore <= alpha){
+                    SEARCH_STAT(razorCutoffs++);
                     return alpha; // we fail to find a significant capture, so we return alpha
                 }
             }
         }
 
-        
+        // probcut
+        // a capture that still beats beta by a margin on a qsearch and then a reduced search
+        // means a full search would almost surely fail high too
+        int probCutBeta = beta + searchParams.probCutMargin;
+        if (!isPvs && !isInCheck && searchParams.probCutDepth > 0 && depth >= searchParams.probCutDepth && abs(beta) < (MATE_SCORE - MAXDEPTH)){
+            Movelist captures;
+            movegen::pseudolegalmoves<MoveGenType::CAPTURE>(captures, board);
+            scoreMoves(captures, ply, ttMove);
+            sortMoves(captures);
+
+            for (const Move& move : captures) {
+                // only captures that win enough material on their own are worth verifying
+                if (!see(move, probCutBeta - staticEval, info) || !info.isLegal(board, move)){
+                    continue;
+                }
 
+                SEARCH_STAT(probCutTries++);
+                searchState.nodes++;
+                board.makeMove(move);
+                int score = -quiescence(-probCutBeta, -probCutBeta + 1, ply + 1);
+                if (score >= probCutBeta){
+                    score = -negamax(depth - 1 - searchParams.probCutReduction, -probCutBeta, -probCutBeta + 1, ply + 1, false);
+                }
+                board.unmakeMove(move);
 
-        Movelist moves;
-        movegen::legalmoves<MoveGenType::ALL>(moves, board);
+                if (isTimeOver()) {
+                    return 0;
+                }
+                if (score >= probCutBeta){
+                    SEARCH_STAT(probCutCutoffs++);
+                    return score;
+                }
+            }
+        }
+
+        // internal iterative deepening / reductions
+        // without a tt move we fall back to mvv-lva, killers and history, which orders badly this deep
+        if (ttMove == Move::NO_MOVE && !isInCheck && !isRoot){
+            // pv nodes are worth a shallow search to seed a move
+            // (only strictly shallower, the inner search has no tt move either and would start another one)
+            if (isPvs && searchParams.iidDepth > 0 && searchParams.iidReduction >= 1 && depth >= searchParams.iidDepth
+                && depth - searchParams.iidReduction >= 1){
+                SEARCH_STAT(iidSearches++);
+                pvTable[ply][ply] = Move::NO_MOVE;
+                negamax(depth - searchParams.iidReduction, alpha, beta, ply, false);
+                if (isTimeOver()) {
+                    return 0;
+                }
+                ttMove = pvTable[ply][ply];
+            }
+            // everywhere else just search the node a little less deep
+            else if (searchParams.iirDepth > 0 && depth >= searchParams.iirDepth){
+                SEARCH_STAT(iirReductions++);
+                depth--;
+            }
+        }
 
-        if (moves.size() == 0) {
-                // Check for checkmate or stalemate
-                return isInCheck ? (-MATE_SCORE + ply) : 0;
+        // below the root, moves are generated pseudo legal and only checked
+        // for legality once they are picked, since a cutoff often comes first
+        Movelist moves;
+        if (isRoot) {
+            movegen::legalmoves<MoveGenType::ALL>(moves, board);
+            // with a tablebase hit at the root, only the moves that keep the result get searched
+            if (!tbRootMoves.empty()) {
+                moves = tbRootMoves;
             }
+        }
+        else {
+            movegen::pseudolegalmoves<MoveGenType::ALL>(moves, board);
+        }
 
         scoreMoves(moves, ply, ttMove);
         Move move = Move::NO_MOVE;
+        Move bestMove = Move::NO_MOVE;
+        int moveIndex = 0;
+
+        while(( move = pickMove(moveIndex++, moves)) != Move::NO_MOVE) {
+            if (!isRoot && !info.isLegal(board, move)) {
+                continue;
+            }
 
-        while(( move = pickMove(moveCount, moves)) != Move::NO_MOVE) {
             bool isCapture = board.at<PieceType>(move.to()) != PieceType::NONE;
             bool isPromotion = move.typeOf() == move.PROMOTION;
 
             searchState.nodes++;
             moveCount++;
             board.makeMove(move);
+            // start loading the child's tt entry now, the pruning checks below hide some of the miss
+            tt.prefetch(board.hash());
 
             // late move pruning (probably need to expose to tuner)
             if (!isCapture && !isPromotion && !board.inCheck() && !isPvs && !isInCheck && depth <= 1 && moveCount > searchParams.lmpMoveCount){
+                SEARCH_STAT(lmpPrunes++);
                 board.unmakeMove(move);
                 continue;
             }
@@ -426,8 +669,12 @@ class Searcher2 {
                 if (r > depth - 1) {
                     r = depth - 1; // clamp to a reasonable value
                 }
+                SEARCH_STAT(lmrReductions++);
                 score = -negamax(depth - r, -alpha - 1, -alpha, ply + 1, false);
                 doReSearch = score > alpha;
+                if (doReSearch) {
+                    SEARCH_STAT(lmrReSearches++);
+                }
             }
             else
                 doReSearch = !isPvs|| moveCount > 1;
@@ -439,6 +686,9 @@ class Searcher2 {
 
             // PVS search or failed null window search
             if (isPvs && ((score > alpha && score < beta) || moveCount == 1)) {
+                if (moveCount > 1) {
+                    SEARCH_STAT(pvsReSearches++);
+                }
                 score = -negamax(depth - 1, -beta, -alpha, ply + 1, false);
             }
             
@@ -446,13 +696,14 @@ class Searcher2 {
 
             // an essential check, because otherwise we will update 
             // our searchState without a full search
-            if (stopSearching) {
+            if (isTimeOver()) {
                 return 0;
             }
 
              
             if (score > best){
                 best = score;
+                bestMove = move;
                 // update the PV
                 pvTable[ply][ply] = move;
                 for (int next_ply = ply + 1; next_ply < pvLength[ply + 1]; next_ply++) {
@@ -467,6 +718,7 @@ class Searcher2 {
                     
                     if (score >= beta) {
                         nodeType = NodeType::LOWERBOUND;
+                        SEARCH_STAT(cutoffAt(moveCount - 1));
                         // update killer bc beta cutoff
                         if (!isCapture && move != searchState.killerMoves[0][ply] || move != searchState.killerMoves[1][ply]){
                             searchState.killerMoves[1][ply] = searchState.killerMoves[0][ply];
@@ -483,11 +735,16 @@ class Searcher2 {
             }
         }
 
+        if (moveCount == 0) {
+            // Check for checkmate or stalemate
+            return isInCheck ? (-MATE_SCORE + ply) : 0;
+        }
+
         nodeType = best >= beta ? NodeType::LOWERBOUND : (isPvs && pvTable[0][ply] != Move::NO_MOVE ? NodeType::EXACT : NodeType::UPPERBOUND);
 
         // make sure we don't store a mate score, or a in the tt
-        if ((best < MATE_SCORE - MAXDEPTH) && !stopSearching){
-            tt.save(zobristKey, depth, best, nodeType, pvTable[0][ply]);
+        if ((best < MATE_SCORE - MAXDEPTH) && !isTimeOver()){
+            tt.save(zobristKey, depth, best, nodeType, bestMove);
         }
 
         
@@ -586,8 +843,96 @@ class Searcher2 {
         
     }
 
-    int evaluate(bool isLazy) {
-        int eval = evaluator.evaluate(isLazy);
+    // static exchange evaluation (threshold version, inspired by stockfish)
+    // returns true if the exchange sequence started by move wins at least threshold
+    // pins are ignored, and special moves (castling, promotions, en passant) count as even trades
+    bool see(const Move& move, int threshold, const AttackInfo& info) {
+        if (move.typeOf() != Move::NORMAL){
+            return 0 >= threshold;
+        }
+
+        Square from = move.from();
+        Square to = move.to();
+
+        int swap = piece_values[0][static_cast<int>(board.at<PieceType>(to))] - threshold;
+        if (swap < 0){
+            return false;
+        }
+
+        // nothing of theirs can reach the square, not even through the moving piece
+        Color them = ~board.sideToMove();
+        if (!(info.all[static_cast<int>(them)] & (1ULL << to)) && !(info.sliderAttacks(them) & (1ULL << from))){
+            return true;
+        }
+
+        swap = piece_values[0][static_cast<int>(board.at<PieceType>(from))] - swap;
+        if (swap <= 0){
+            return true;
+        }
+
+        Bitboard occ = board.occ() ^ (1ULL << from) ^ (1ULL << to);
+        Bitboard bishopsQueens = board.pieces(PieceType::BISHOP) | board.pieces(PieceType::QUEEN);
+        Bitboard rooksQueens = board.pieces(PieceType::ROOK) | board.pieces(PieceType::QUEEN);
+        Bitboard attackers = attacks::attackers(board, Color::WHITE, to, occ) | attacks::attackers(board, Color::BLACK, to, occ);
+        Color side = board.sideToMove();
+        int res = 1;
+
+        while (true) {
+            side = ~side;
+            attackers &= occ;
+
+            Bitboard sideAttackers = attackers & board.us(side);
+            if (!sideAttackers){
+                break;
+            }
+
+            res ^= 1;
+
+            // recapture with the least valuable piece, and uncover any x-ray attackers behind it
+            Bitboard bb;
+            if ((bb = sideAttackers & board.pieces(PieceType::PAWN))){
+                if ((swap = piece_values[0][0] - swap) < res) break;
+                occ ^= bb & -bb;
+                attackers |= attacks::bishop(to, occ) & bishopsQueens;
+            }
+            else if ((bb = sideAttackers & board.pieces(PieceType::KNIGHT))){
+                if ((swap = piece_values[0][1] - swap) < res) break;
+                occ ^= bb & -bb;
+            }
+            else if ((bb = sideAttackers & board.pieces(PieceType::BISHOP))){
+                if ((swap = piece_values[0][2] - swap) < res) break;
+                occ ^= bb & -bb;
+                attackers |= attacks::bishop(to, occ) & bishopsQueens;
+            }
+            else if ((bb = sideAttackers & board.pieces(PieceType::ROOK))){
+                if ((swap = piece_values[0][3] - swap) < res) break;
+                occ ^= bb & -bb;
+                attackers |= attacks::rook(to, occ) & rooksQueens;
+            }
+            else if ((bb = sideAttackers & board.pieces(PieceType::QUEEN))){
+                if ((swap = piece_values[0][4] - swap) < res) break;
+                occ ^= bb & -bb;
+                attackers |= (attacks::bishop(to, occ) & bishopsQueens) | (attacks::rook(to, occ) & rooksQueens);
+            }
+            else {
+                // the king can only recapture if the other side has nothing left to take back with
+                return (attackers & ~board.us(side)) ? res ^ 1 : res;
+            }
+        }
+
+        return bool(res);
+    }
+
+    const AttackInfo& attackInfoAt(int ply) {
+        AttackInfo& info = attackInfo[ply];
+        if (info.key != board.hash()){
+            info.compute(board);
+        }
+        return info;
+    }
+
+    int evaluate(bool isLazy, const AttackInfo& info) {
+        int eval = isLazy ? evaluator.evaluate(true) : evaluator.evaluate(info);
         if (board.sideToMove() == Color::BLACK){
             return -eval;
         }
@@ -0,0 +1,142 @@
+// syzygy endgame tablebase probing, through the Fathom probing code
+// Fathom is not part of this repo: to use tablebases, put tbprobe.c, tbprobe.h and tbconfig.h
+// from https://github.com/jdart1/Fathom in chess/engine/fathom/ and build with
+//   g++ -std=c++17 -O3 -march=native -DUSE_SYZYGY base_engine.cpp fathom/tbprobe.c -o base_engine
+// (tbprobe.c is C, so compile it with gcc into an object first if your g++ complains)
+// without USE_SYZYGY everything here reports that no tablebases are loaded, so the search
+// behaves exactly like before. Fathom memory maps the .rtbw/.rtbz files itself
+#pragma once
+#include <string>
+#include "chess.hpp"
+#ifdef USE_SYZYGY
+extern "C" {
+#include "fathom/tbprobe.h"
+}
+#endif
+
+using namespace chess;
+
+namespace syzygy {
+
+// the win/draw/loss of a position for the side to move, with the 50 move rule taken into account
+// (a cursed win or blessed loss only wins or loses if the 50 move rule is ignored, so it counts as a draw)
+enum class Wdl {
+    LOSS,
+    DRAW,
+    WIN,
+    FAILED // no table for this position, or it can't be probed (castling rights, halfmove clock)
+};
+
+// largest number of pieces we have tables for, 0 when none are loaded
+inline int largest() {
+#ifdef USE_SYZYGY
+    return static_cast<int>(TB_LARGEST);
+#else
+    return 0;
+#endif
+}
+
+// loads the tables in path (several directories separated by ':', or ';' on windows)
+// an empty path unloads them, returns whether any tables were found
+inline bool init(const std::string& path) {
+#ifdef USE_SYZYGY
+    tb_free();
+    if (path.empty() || path == "<empty>") {
+        return false;
+    }
+    return tb_init(path.c_str()) && largest() > 0;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+// true if there could be a table for this position, cheap enough to call at every node
+inline bool canProbe(const Board& board) {
+    return largest() > 0 && builtin::popcount(board.occ()) <= largest() && board.castlingRights().isEmpty();
+}
+
+#ifdef USE_SYZYGY
+inline Wdl toWdl(unsigned result) {
+    switch (result) {
+        case TB_WIN: return Wdl::WIN;
+        case TB_LOSS: return Wdl::LOSS;
+        default: return Wdl::DRAW;
+    }
+}
+
+inline unsigned enpassant(const Board& board) {
+    return board.enpassantSq() == Square::NO_SQ ? 0 : static_cast<unsigned>(board.enpassantSq());
+}
+#endif
+
+// wdl probe for positions inside the search, only works right after a capture or pawn move
+inline Wdl probeWdl(const Board& board) {
+#ifdef USE_SYZYGY
+    if (!canProbe(board) || board.halfMoveClock() != 0) {
+        return Wdl::FAILED;
+    }
+    unsigned result = tb_probe_wdl(board.us(Color::WHITE), board.us(Color::BLACK),
+                                   board.pieces(PieceType::KING), board.pieces(PieceType::QUEEN),
+                                   board.pieces(PieceType::ROOK), board.pieces(PieceType::BISHOP),
+                                   board.pieces(PieceType::KNIGHT), board.pieces(PieceType::PAWN),
+                                   0, 0, enpassant(board), board.sideToMove() == Color::WHITE);
+    return result == TB_RESULT_FAILED ? Wdl::FAILED : toWdl(result);
+#else
+    (void)board;
+    return Wdl::FAILED;
+#endif
+}
+
+// dtz probe at the root: fills moves with the legal moves that keep the best result
+// (and so never throw away a win or walk into a loss), returns that result
+inline Wdl probeRoot(const Board& board, Movelist& moves) {
+    moves.clear();
+#ifdef USE_SYZYGY
+    if (!canProbe(board)) {
+        return Wdl::FAILED;
+    }
+    unsigned results[TB_MAX_MOVES];
+    unsigned best = tb_probe_root(board.us(Color::WHITE), board.us(Color::BLACK),
+                                  board.pieces(PieceType::KING), board.pieces(PieceType::QUEEN),
+                                  board.pieces(PieceType::ROOK), board.pieces(PieceType::BISHOP),
+                                  board.pieces(PieceType::KNIGHT), board.pieces(PieceType::PAWN),
+                                  board.halfMoveClock(), 0, enpassant(board), board.sideToMove() == Color::WHITE, results);
+    if (best == TB_RESULT_FAILED || best == TB_RESULT_CHECKMATE || best == TB_RESULT_STALEMATE) {
+        return Wdl::FAILED;
+    }
+    const Wdl bestWdl = toWdl(TB_GET_WDL(best));
+
+    Movelist legal;
+    movegen::legalmoves<MoveGenType::ALL>(legal, board);
+    for (unsigned i = 0; results[i] != TB_RESULT_FAILED; i++) {
+        if (toWdl(TB_GET_WDL(results[i])) != bestWdl) {
+            continue;
+        }
+        const Square from = Square(TB_GET_FROM(results[i]));
+        const Square to = Square(TB_GET_TO(results[i]));
+        const unsigned promotes = TB_GET_PROMOTES(results[i]);
+        for (const Move& move : legal) {
+            if (move.from() != from || move.to() != to) {
+                continue;
+            }
+            bool isPromotion = move.typeOf() == Move::PROMOTION;
+            if (!isPromotion && promotes == TB_PROMOTES_NONE) {
+                moves.add(move);
+            }
+            else if (isPromotion && ((promotes == TB_PROMOTES_QUEEN && move.promotionType() == PieceType::QUEEN)
+                                  || (promotes == TB_PROMOTES_ROOK && move.promotionType() == PieceType::ROOK)
+                                  || (promotes == TB_PROMOTES_BISHOP && move.promotionType() == PieceType::BISHOP)
+                                  || (promotes == TB_PROMOTES_KNIGHT && move.promotionType() == PieceType::KNIGHT))) {
+                moves.add(move);
+            }
+        }
+    }
+    return moves.empty() ? Wdl::FAILED : bestWdl;
+#else
+    (void)board;
+    return Wdl::FAILED;
+#endif
+}
+
+}
@@ -1,9 +1,19 @@
 // note, this is a bit over my head in terms of how it all works
 // mostly stolen from chat gpt's suggestions
 
-//note also thats its a vector as the data structure, perhaps a fixed sized array would be better?
 #include <vector>
 #include <optional>
+#include <thread>
+#include <memory>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 #include "chess.hpp"
 
 using namespace chess;
@@ -21,40 +31,138 @@ struct TTEntry {
     int score = 0;
     NodeType nodeType;
     Move bestMove;
-    bool valid = false; // Indicates if the entry is valid
+    uint8_t generation = 0; // the table generation that wrote the entry, 0 for never written
 };
 
 class TranspositionTable {
 public:
-    TranspositionTable(size_t size) : table(size) {}
+    // size is in entries and is rounded down to a power of two, so the index is just a mask
+    TranspositionTable(size_t size) {
+        resize(size);
+    }
+
+    ~TranspositionTable() {
+        release(table);
+    }
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // the largest power of two number of entries that fits in megabytes
+    static size_t entriesForMegabytes(size_t megabytes) {
+        return (megabytes << 20) / sizeof(TTEntry);
+    }
+
+    // throws away everything in the table
+    // the new table is allocated before the old one goes, so if that throws the old one is still usable
+    void resize(size_t size) {
+        size_t entries = 1;
+        while (entries * 2 <= size) {
+            entries *= 2;
+        }
+        TTEntry* fresh = allocate(entries);
+        release(table);
+        table = fresh;
+        mask = entries - 1;
+        generation = 1;
+    }
 
     void save(uint64_t zobristKey, int depth, int score, NodeType nodeType, Move bestMove) {
-        size_t index = zobristKey % table.size();
+        size_t index = zobristKey & mask;
         // Depth-preferred replacement strategy
-        if (!table[index].valid || table[index].depth < depth) {
-            table[index] = {zobristKey, depth, score, nodeType, bestMove, true};
+        if (table[index].generation != generation || table[index].depth < depth) {
+            table[index] = {zobristKey, depth, score, nodeType, bestMove, generation};
         }
     }
 
     std::optional<TTEntry> retrieve(uint64_t zobristKey) {
-        size_t index = zobristKey % table.size();
-        if (table[index].valid && table[index].zobristKey == zobristKey) {
+        size_t index = zobristKey & mask;
+        if (table[index].generation == generation && table[index].zobristKey == zobristKey) {
             return table[index];
         }
         return {};
     }
 
+    // pulls the entry for zobristKey into the cache ahead of a retrieve
+    void prefetch(uint64_t zobristKey) const {
+#if defined(__GNUC__) && !defined(NO_TT_PREFETCH)
+        __builtin_prefetch(&table[zobristKey & mask]);
+#else
+        (void)zobristKey;
+#endif
+    }
+
+    // entries only count if they were written in the current generation, so clearing is just
+    // starting a new one, which keeps reusing a searcher for many games cheap
+    // the table is only walked when the generation counter wraps around
     void clear() {
-        for (auto& entry : table) {
-            entry.valid = false; // Mark all entries as invalid
+        if (++generation == 0) {
+            for (size_t i = 0; i < size(); i++) {
+                table[i].generation = 0;
+            }
+            generation = 1;
         }
     }
 
+    size_t size() const {
+        return mask + 1;
+    }
+
     void debugSize() {
-        cout << "Table size: " << table.size() << endl;
-        cout << "Percent full: " << (count_if(table.begin(), table.end(), [](const TTEntry& entry) { return entry.valid; }) / (double)table.size()) * 100 << "%\n " << endl;
+        cout << "Table size: " << size() << endl;
+        cout << "Percent full: " << (count_if(table, table + size(), [this](const TTEntry& entry) { return entry.generation == generation; }) / (double)size()) * 100 << "%\n " << endl;
     }
 
 private:
-    std::vector<TTEntry> table;
+    TTEntry* table = nullptr;
+    size_t mask = 0;
+    uint8_t generation = 1;
+
+    // big tables are aligned to 2MB and marked for transparent huge pages, since the probes
+    // land all over the table and with 4KB pages nearly every one of them is a TLB miss
+    // the entries are then constructed by several threads, which also spreads out the page faults
+    static TTEntry* allocate(size_t entries) {
+        const size_t hugePage = 2 << 20;
+        size_t bytes = entries * sizeof(TTEntry);
+        size_t alignment = bytes >= hugePage ? hugePage : 64;
+        bytes = (bytes + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+        TTEntry* block = static_cast<TTEntry*>(_aligned_malloc(bytes, alignment));
+#else
+        TTEntry* block = static_cast<TTEntry*>(std::aligned_alloc(alignment, bytes));
+#endif
+        if (!block) {
+            throw std::bad_alloc();
+        }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (alignment == hugePage) {
+            madvise(block, bytes, MADV_HUGEPAGE);
+        }
+#endif
+
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        if (bytes < (64 << 20)) {
+            threads = 1; // not worth starting threads for
+        }
+        auto construct = [block, threads, entries](size_t t) {
+            std::uninitialized_value_construct(block + t * entries / threads, block + (t + 1) * entries / threads);
+        };
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < threads; t++) {
+            workers.emplace_back(construct, t);
+        }
+        construct(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        return block;
+    }
+
+    static void release(TTEntry* block) {
+#ifdef _WIN32
+        _aligned_free(block);
+#else
+        std::free(block);
+#endif
+    }
 };
@@ -0,0 +1,293 @@
+// micro benchmarks for the hot paths of the engine
+// build it twice to compare the slider backends, e.g.
+//   g++ -std=c++17 -O3 -march=native bench.cpp -o bench
+//   g++ -std=c++17 -O3 -march=native -DCHESS_NO_PEXT bench.cpp -o bench_magic
+// and the same with -DNO_TT_PREFETCH to see what prefetching the tt is worth in the search line
+// pass an engine binary to also time how long it takes to answer uci, e.g.
+//   ./bench ../engine/base_engine
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../engine/chess.hpp"
+#include "../engine/evaluator.hpp"
+#include "../engine/attack_info.hpp"
+#include "../engine/baselines.hpp"
+#include "../engine/searcher2.hpp"
+#include "../../ga/batch_evaluator.hpp"
+
+using namespace chess;
+
+// a mix of openings, middlegames and endgames
+const std::vector<std::string> benchFens = {
+    constants::STARTPOS,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "3r1r1b/ppq2p1k/2p1p1p1/4Nn1n/2PP1P1p/1PQ2R1P/PB2N1P1/3R2K1 b - - 0 1",
+    "8/8/8/8/p1k5/P1p4p/2K4P/8 w - - 0 61",
+    "8/8/8/4k3/8/8/2RK4/8 w - - 0 1",
+    "8/5k2/2b2p2/p3p3/P3P3/2B2P2/5K2/8 w - - 0 1",
+};
+
+double secondsSince(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void benchSliders() {
+    const int n = 1 << 16;
+    const int rounds = 200;
+    std::mt19937_64 rng(42);
+    std::vector<Square> squares(n);
+    std::vector<Bitboard> occupancies(n);
+    for (int i = 0; i < n; i++) {
+        squares[i] = Square(rng() % 64);
+        occupancies[i] = rng() & rng(); // roughly a quarter of the board occupied
+    }
+
+    Bitboard sink = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < n; i++) {
+            sink ^= attacks::rook(squares[i], occupancies[i] ^ sink);
+            sink ^= attacks::bishop(squares[i], occupancies[i] ^ sink);
+        }
+    }
+    double t = secondsSince(start);
+    std::cout << "sliders:  " << (t * 1e9) / (2.0 * n * rounds) << " ns/lookup (" << (sink & 1) << ")" << std::endl;
+}
+
+uint64_t perft(Board& board, int depth) {
+    Movelist moves;
+    movegen::legalmoves<MoveGenType::ALL>(moves, board);
+    if (depth == 1) {
+        return moves.size();
+    }
+    uint64_t nodes = 0;
+    for (const Move& move : moves) {
+        board.makeMove(move);
+        nodes += perft(board, depth - 1);
+        board.unmakeMove(move);
+    }
+    return nodes;
+}
+
+// same as perft, but with the pseudo legal generator and the AttackInfo legality check the search uses
+uint64_t perftPseudo(Board& board, int depth) {
+    Movelist moves;
+    movegen::pseudolegalmoves<MoveGenType::ALL>(moves, board);
+    AttackInfo info;
+    info.compute(board);
+    uint64_t nodes = 0;
+    for (const Move& move : moves) {
+        if (!info.isLegal(board, move)) {
+            continue;
+        }
+        if (depth == 1) {
+            nodes++;
+            continue;
+        }
+        board.makeMove(move);
+        nodes += perftPseudo(board, depth - 1);
+        board.unmakeMove(move);
+    }
+    return nodes;
+}
+
+void benchMovegen() {
+    Board board;
+    uint64_t nodes = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const std::string& fen : benchFens) {
+        board.setFen(fen);
+        nodes += perft(board, 4);
+    }
+    double t = secondsSince(start);
+    std::cout << "perft 4:  " << nodes << " nodes, " << static_cast<uint64_t>(nodes / t) << " nps" << std::endl;
+
+    uint64_t pseudoNodes = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (const std::string& fen : benchFens) {
+        board.setFen(fen);
+        pseudoNodes += perftPseudo(board, 4);
+    }
+    t = secondsSince(start);
+    std::cout << "pseudo 4: " << pseudoNodes << " nodes, " << static_cast<uint64_t>(pseudoNodes / t) << " nps"
+              << (pseudoNodes == nodes ? "" : " MISMATCH") << std::endl;
+}
+
+void benchEval() {
+    const int rounds = 100000;
+    Board board;
+    Evaluator evaluator(board, baseEval);
+    float sink = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const std::string& fen : benchFens) {
+        board.setFen(fen);
+        for (int r = 0; r < rounds; r++) {
+            sink += evaluator.evaluate(false);
+        }
+    }
+    double t = secondsSince(start);
+    std::cout << "eval:     " << (t * 1e9) / (double(rounds) * benchFens.size()) << " ns/eval (" << (sink != 0) << ")" << std::endl;
+}
+
+// fixed depth searches with the engine's default tt size, where most tt probes miss the cache
+void benchSearch() {
+    const int depth = 8;
+    Board board;
+    Searcher2 searcher(board, baseSearch, baseEval);
+    searcher.setVerbose(false);
+    long nodes = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const std::string& fen : benchFens) {
+        board.setFen(fen);
+        searcher.newGame();
+        nodes += searcher.fixedSearch(depth, 0).nodes;
+    }
+    double t = secondsSince(start);
+#ifdef NO_TT_PREFETCH
+    const char* prefetch = "off";
+#else
+    const char* prefetch = "on";
+#endif
+    std::cout << "search " << depth << ": " << nodes << " nodes, " << static_cast<uint64_t>(nodes / t) << " nps (tt prefetch " << prefetch << ")" << std::endl;
+}
+
+// the ga's fitness over 20k positions, one position at a time vs all at once
+void benchBatchEval() {
+    const int n = 20000;
+    std::vector<std::string> fens;
+    std::vector<double> targets;
+    for (int i = 0; i < n; i++) {
+        fens.push_back(benchFens[i % benchFens.size()]);
+        targets.push_back(0);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Board board;
+    Evaluator evaluator(board, baseEval);
+    double scalarFitness = 0;
+    int scored = 0;
+    for (const std::string& fen : fens) {
+        board.setFen(fen);
+        // the batch leaves out what a specialized endgame scores, so the fitness has to as well
+        EndgameScore endgame;
+        if (Endgames::instance().probe(board, endgame)) {
+            continue;
+        }
+        scalarFitness += std::abs(evaluator.evaluate(false));
+        scored++;
+    }
+    scalarFitness /= scored;
+    double scalarTime = secondsSince(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    BatchEvaluator batch;
+    batch.reserve(n);
+    for (const std::string& fen : fens) {
+        batch.add(fen);
+    }
+    double extractTime = secondsSince(start);
+
+    // what the ga does each generation, now that positions are packed when the csv is read
+    std::vector<PackedPosition> packed;
+    for (const std::string& fen : fens) {
+        board.setFen(fen);
+        packed.push_back(PackedPosition::pack(board));
+    }
+    start = std::chrono::high_resolution_clock::now();
+    BatchEvaluator packedBatch;
+    packedBatch.reserve(n);
+    for (const PackedPosition& position : packed) {
+        packedBatch.add(position);
+    }
+    double packedExtractTime = secondsSince(start);
+
+    const int rounds = 100;
+    double batchFitness = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        batchFitness = batch.meanAbsoluteError(baseEval, targets);
+    }
+    double batchTime = secondsSince(start) / rounds;
+
+    std::cout << "fitness:  " << scalarTime * 1e3 << " ms scalar, " << batchTime * 1e6 << " us batched ("
+              << extractTime * 1e3 << " ms to extract once) for " << n << " positions"
+              << (std::abs(scalarFitness - batchFitness) < 0.01 ? "" : " MISMATCH") << std::endl;
+    std::cout << "extract:  " << extractTime * 1e3 << " ms from fens, " << packedExtractTime * 1e3 << " ms from packed positions"
+              << (std::abs(packedBatch.meanAbsoluteError(baseEval, targets) - batchFitness) < 1e-9 ? "" : " MISMATCH") << std::endl;
+}
+
+// time from starting the engine process until it prints uciok
+double uciStartupMs(const char* engine) {
+    int toEngine[2], fromEngine[2];
+    if (pipe(toEngine) || pipe(fromEngine)) {
+        return -1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(toEngine[0], STDIN_FILENO);
+        dup2(fromEngine[1], STDOUT_FILENO);
+        close(toEngine[1]);
+        close(fromEngine[0]);
+        execl(engine, engine, (char*) nullptr);
+        _exit(1);
+    }
+    close(toEngine[0]);
+    close(fromEngine[1]);
+
+    const std::string uci = "uci\n";
+    write(toEngine[1], uci.data(), uci.size());
+
+    std::string output;
+    char buffer[256];
+    ssize_t n;
+    while (output.find("uciok") == std::string::npos && (n = read(fromEngine[0], buffer, sizeof(buffer))) > 0) {
+        output.append(buffer, n);
+    }
+    double ms = secondsSince(start) * 1000;
+
+    const std::string quit = "quit\n";
+    write(toEngine[1], quit.data(), quit.size());
+    close(toEngine[1]);
+    close(fromEngine[0]);
+    waitpid(pid, nullptr, 0);
+
+    return output.find("uciok") == std::string::npos ? -1 : ms;
+}
+
+void benchStartup(const char* engine) {
+    const int runs = 20;
+    std::vector<double> times;
+    for (int i = 0; i < runs; i++) {
+        times.push_back(uciStartupMs(engine));
+    }
+    std::sort(times.begin(), times.end());
+    if (times[0] < 0) {
+        std::cout << "startup:  could not run " << engine << std::endl;
+        return;
+    }
+    std::cout << "startup:  " << times[runs / 2] << " ms to uciok (median of " << runs << ", includes fork/exec)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::cout << "slider backend: " << attacks::sliderBackend() << std::endl;
+    benchSliders();
+    benchMovegen();
+    benchEval();
+    benchBatchEval();
+    benchSearch();
+    if (argc > 1) {
+        benchStartup(argv[1]);
+    }
+    return 0;
+}
@@ -0,0 +1,514 @@
+// plays two engine configurations against each other inside one process, instead of
+// running cutechess-cli with a process and uci pipes per engine (see cutechess_command_ex.txt)
+// an engine is a preset (base, tuned_eval, tuned_search_eval, the names from our cutechess runs)
+// or a search and an eval from the result headers, written search/eval, e.g. resultX2/ga1result10
+//   g++ -std=c++17 -O3 -march=native -pthread match.cpp -o match
+//   ./match tuned_search_eval base --book ../openingbook/Titans.bin --nodes 60000 --rounds 1000
+//   ./match resultX2/ga1result10 resultX/ga1result10 --tc 10+0.1 --concurrency 4 --pgn searcher2.pgn
+// every round is one opening played twice with colors swapped, and rounds are the unit of work
+// for the thread pool. Each worker thread keeps a board and one searcher per engine for all its games
+// the sprt (elo0=0 elo1=10 by default, like our cutechess runs) goes over the rounds in opening order,
+// and the searchers are fully reset between games (Searcher2::newGame), so with --nodes or --depth
+// every round's games and the sprt decision (and the round it is made at) only depend on the seed,
+// not on --concurrency. Rounds already running when the test decides still finish and count in the score
+// openings come from the polyglot book, --book-depth plies deep; where the book has no move
+// (or there is no book) random legal moves are played instead, so the openings never all look the same
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <iomanip>
+#include "../engine/chess.hpp"
+#include "../engine/baselines.hpp"
+#include "../engine/ga1results.hpp"
+#include "../engine/ga3and5results.hpp"
+#include "../engine/searcher2.hpp"
+#include "../engine/polyglot.hpp"
+#include "../../ga/thread_pool.hpp"
+#include "../../ga/sprt.hpp"
+
+using namespace chess;
+
+struct EngineConfig {
+    std::string name;
+    TunableSearch search;
+    TunableEval eval;
+};
+
+// what every move of a game may use, a clock (base + increment) or fixed depth/nodes
+struct Control {
+    int depth = 0;
+    long nodes = 0;
+    int baseMs = 0;
+    int incrementMs = 0;
+    int maxMoves = 200; // full moves, after that the game is a draw
+
+    bool hasClock() const {
+        return baseMs > 0;
+    }
+
+    std::string toString() const {
+        if (hasClock()) {
+            std::ostringstream tc;
+            tc << baseMs / 1000.0 << "+" << incrementMs / 1000.0;
+            return tc.str();
+        }
+        return (depth ? "depth " + std::to_string(depth) : "") + (depth && nodes ? " " : "")
+             + (nodes ? "nodes " + std::to_string(nodes) : "");
+    }
+};
+
+struct GameRecord {
+    std::vector<Move> moves; // from the start position, the opening included
+    int result = 0; // 1 white won, -1 black won, 0 draw
+    std::string termination;
+};
+
+const std::map<std::string, const TunableSearch*> searches = {
+    {"baseSearch", &baseSearch},
+    {"Games10Ga5", &Games10Ga5},
+    {"Games100Ga5BaseOpp", &Games100Ga5BaseOpp},
+    {"resultX", &resultX},
+    {"resultX2", &resultX2},
+};
+
+const std::map<std::string, const TunableEval*> evals = {
+    {"baseEval", &baseEval},
+    {"ga1result1", &ga1result1}, {"ga1result2", &ga1result2}, {"ga1result3", &ga1result3},
+    {"ga1result4", &ga1result4}, {"ga1result5", &ga1result5}, {"ga1result6", &ga1result6},
+    {"ga1result7", &ga1result7}, {"ga1result8", &ga1result8}, {"ga1result9", &ga1result9},
+    {"ga1result10", &ga1result10}, {"ga1result11", &ga1result11},
+    {"ga3result1", &ga3result1}, {"ga3result2", &ga3result2},
+};
+
+// the engines from our cutechess runs, base_engine itself is tuned_search_eval
+const std::map<std::string, std::pair<std::string, std::string>> presets = {
+    {"base", {"baseSearch", "baseEval"}},
+    {"tuned_eval", {"baseSearch", "ga1result10"}},
+    {"tuned_search_eval", {"resultX2", "ga1result10"}},
+};
+
+bool parseEngine(const std::string& spec, EngineConfig& engine) {
+    std::string search;
+    std::string eval;
+    auto preset = presets.find(spec);
+    if (preset != presets.end()) {
+        search = preset->second.first;
+        eval = preset->second.second;
+    }
+    else {
+        const size_t slash = spec.find('/');
+        if (slash == std::string::npos) {
+            return false;
+        }
+        search = spec.substr(0, slash);
+        eval = spec.substr(slash + 1);
+    }
+    auto s = searches.find(search);
+    auto e = evals.find(eval);
+    if (s == searches.end() || e == evals.end()) {
+        return false;
+    }
+    engine = {spec, *s->second, *e->second};
+    return true;
+}
+
+std::vector<Move> pickOpening(PolyglotBook& book, int plies, std::mt19937& rng) {
+    std::vector<Move> opening;
+    Board board;
+    while (static_cast<int>(opening.size()) < plies) {
+        Move move = book.pickRandomMove(board, rng);
+        if (move == Move::NULL_MOVE) {
+            Movelist legal;
+            movegen::legalmoves<MoveGenType::ALL>(legal, board);
+            if (legal.empty()) {
+                break;
+            }
+            move = legal[std::uniform_int_distribution<int>(0, legal.size() - 1)(rng)];
+        }
+        board.makeMove(move);
+        opening.push_back(move);
+    }
+    return opening;
+}
+
+std::string reasonToString(GameResultReason reason) {
+    switch (reason) {
+        case GameResultReason::CHECKMATE: return "checkmate";
+        case GameResultReason::STALEMATE: return "stalemate";
+        case GameResultReason::INSUFFICIENT_MATERIAL: return "insufficient material";
+        case GameResultReason::FIFTY_MOVE_RULE: return "fifty move rule";
+        case GameResultReason::THREEFOLD_REPETITION: return "threefold repetition";
+        default: return "";
+    }
+}
+
+GameRecord playGame(Searcher2& white, Searcher2& black, Board& board, const std::vector<Move>& opening, const Control& control) {
+    GameRecord game;
+    board.setFen(constants::STARTPOS);
+    for (const Move& move : opening) {
+        board.makeMove(move);
+        game.moves.push_back(move);
+    }
+    white.newGame();
+    black.newGame();
+    long clock[2] = {control.baseMs, control.baseMs};
+
+    while (true) {
+        auto [reason, result] = board.isGameOver();
+        if (result != GameResult::NONE) {
+            // isGameOver is from the side to move's point of view
+            const int sign = board.sideToMove() == Color::WHITE ? 1 : -1;
+            game.result = result == GameResult::LOSE ? -sign : result == GameResult::WIN ? sign : 0;
+            game.termination = reasonToString(reason);
+            break;
+        }
+        if (static_cast<int>(game.moves.size()) >= 2 * control.maxMoves) {
+            game.termination = "max moves";
+            break;
+        }
+
+        const int side = static_cast<int>(board.sideToMove());
+        Searcher2& searcher = board.sideToMove() == Color::WHITE ? white : black;
+        SearchState state;
+        if (control.hasClock()) {
+            auto start = std::chrono::high_resolution_clock::now();
+            state = searcher.iterativeDeepening(clock[side], control.incrementMs, 30);
+            clock[side] -= std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+            if (clock[side] < 0) {
+                game.result = side == 0 ? -1 : 1;
+                game.termination = "time forfeit";
+                break;
+            }
+            clock[side] += control.incrementMs;
+        }
+        else {
+            state = searcher.fixedSearch(control.depth, control.nodes);
+        }
+
+        Movelist legal;
+        movegen::legalmoves<MoveGenType::ALL>(legal, board);
+        if (std::find(legal.begin(), legal.end(), state.bestMove) == legal.end()) {
+            game.result = side == 0 ? -1 : 1;
+            game.termination = "illegal move " + uci::moveToUci(state.bestMove);
+            break;
+        }
+        board.makeMove(state.bestMove);
+        game.moves.push_back(state.bestMove);
+    }
+    return game;
+}
+
+std::string resultString(int result) {
+    return result > 0 ? "1-0" : result < 0 ? "0-1" : "1/2-1/2";
+}
+
+std::string toPgn(const GameRecord& game, const std::string& whiteName, const std::string& blackName,
+                  const std::string& round, const std::string& timeControl, const std::string& date) {
+    std::ostringstream pgn;
+    pgn << "[Event \"match\"]\n"
+        << "[Site \"?\"]\n"
+        << "[Date \"" << date << "\"]\n"
+        << "[Round \"" << round << "\"]\n"
+        << "[White \"" << whiteName << "\"]\n"
+        << "[Black \"" << blackName << "\"]\n"
+        << "[Result \"" << resultString(game.result) << "\"]\n"
+        << "[TimeControl \"" << timeControl << "\"]\n"
+        << "[PlyCount \"" << game.moves.size() << "\"]\n"
+        << "[Termination \"" << game.termination << "\"]\n\n";
+
+    Board board;
+    std::string line;
+    for (size_t i = 0; i < game.moves.size(); i++) {
+        std::string token = (i % 2 == 0 ? std::to_string(i / 2 + 1) + ". " : "") + uci::moveToSan(board, game.moves[i]);
+        board.makeMove(game.moves[i]);
+        if (line.size() + token.size() + 1 > 80) {
+            pgn << line << "\n";
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + token;
+    }
+    const std::string result = resultString(game.result);
+    if (line.size() + result.size() + 1 > 80) {
+        pgn << line << "\n";
+        line.clear();
+    }
+    pgn << line << (line.empty() ? "" : " ") << result << "\n\n";
+    return pgn.str();
+}
+
+// elo difference for a score, and the half width of its 95% interval from the pair results
+void estimateElo(const Sprt::Pentanomial& counts, double& elo, double& margin) {
+    auto toElo = [](double score) {
+        score = std::min(std::max(score, 1e-3), 1 - 1e-3);
+        return -400.0 * std::log10(1.0 / score - 1.0);
+    };
+    const int n = Sprt::pairs(counts);
+    elo = margin = 0.0;
+    if (n == 0) {
+        return;
+    }
+    double mean = 0.0;
+    for (int k = 0; k < 5; k++) {
+        mean += counts[k] * (k / 4.0);
+    }
+    mean /= n;
+    double variance = 0.0;
+    for (int k = 0; k < 5; k++) {
+        variance += counts[k] * (k / 4.0 - mean) * (k / 4.0 - mean);
+    }
+    const double deviation = std::sqrt(variance / n / n);
+    elo = toElo(mean);
+    margin = (toElo(mean + 1.96 * deviation) - toElo(mean - 1.96 * deviation)) / 2;
+}
+
+void usage() {
+    std::cerr << "usage: match <engine1> <engine2> [--nodes n] [--depth n] [--tc seconds+increment] [--rounds n]" << std::endl
+              << "    [--concurrency n] [--book file] [--book-depth plies] [--max-moves n] [--hash mb]" << std::endl
+              << "    [--sprt elo0 elo1] [--no-sprt] [--pgn file] [--seed n] [--rating-interval rounds]" << std::endl
+              << "engines are presets (base, tuned_eval, tuned_search_eval) or search/eval, e.g. resultX2/ga1result10" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        usage();
+        return 2;
+    }
+    EngineConfig engines[2];
+    for (int i = 0; i < 2; i++) {
+        if (!parseEngine(argv[i + 1], engines[i])) {
+            std::cerr << "unknown engine " << argv[i + 1] << std::endl;
+            usage();
+            return 2;
+        }
+    }
+
+    Control control;
+    size_t rounds = 500;
+    unsigned concurrency = std::max(1u, std::thread::hardware_concurrency());
+    std::string bookPath = "../openingbook/Titans.bin";
+    int bookDepth = 8;
+    size_t hashMegabytes = 16;
+    double elo0 = 0;
+    double elo1 = 10;
+    bool useSprt = true;
+    std::string pgnPath;
+    unsigned seed = std::random_device{}();
+    size_t ratingInterval = 10;
+
+    for (int i = 3; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--nodes" && hasValue) {
+            control.nodes = std::stol(argv[++i]);
+        } else if (arg == "--depth" && hasValue) {
+            control.depth = std::stoi(argv[++i]);
+        } else if (arg == "--tc" && hasValue) {
+            const std::string tc = argv[++i];
+            const size_t plus = tc.find('+');
+            control.baseMs = static_cast<int>(std::stod(tc.substr(0, plus)) * 1000);
+            control.incrementMs = plus == std::string::npos ? 0 : static_cast<int>(std::stod(tc.substr(plus + 1)) * 1000);
+        } else if (arg == "--rounds" && hasValue) {
+            rounds = std::stoul(argv[++i]);
+        } else if (arg == "--concurrency" && hasValue) {
+            concurrency = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--book" && hasValue) {
+            bookPath = argv[++i];
+        } else if (arg == "--book-depth" && hasValue) {
+            bookDepth = std::stoi(argv[++i]);
+        } else if (arg == "--max-moves" && hasValue) {
+            control.maxMoves = std::stoi(argv[++i]);
+        } else if (arg == "--hash" && hasValue) {
+            hashMegabytes = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--sprt" && i + 2 < argc) {
+            elo0 = std::stod(argv[++i]);
+            elo1 = std::stod(argv[++i]);
+        } else if (arg == "--no-sprt") {
+            useSprt = false;
+        } else if (arg == "--pgn" && hasValue) {
+            pgnPath = argv[++i];
+        } else if (arg == "--seed" && hasValue) {
+            seed = std::stoul(argv[++i]);
+        } else if (arg == "--rating-interval" && hasValue) {
+            ratingInterval = std::max(1, std::stoi(argv[++i]));
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!control.hasClock() && !control.depth && !control.nodes) {
+        control.nodes = 60000;
+    }
+
+    // the openings only depend on the seed, so a match can be replayed exactly
+    PolyglotBook book(bookPath);
+    std::mt19937 openingRng(seed);
+    std::vector<std::vector<Move>> openings;
+    for (size_t r = 0; r < rounds; r++) {
+        openings.push_back(pickOpening(book, bookDepth, openingRng));
+    }
+
+    std::ofstream pgnFile;
+    if (!pgnPath.empty()) {
+        pgnFile.open(pgnPath, std::ios::app);
+        if (!pgnFile) {
+            std::cerr << "could not open " << pgnPath << std::endl;
+            return 2;
+        }
+    }
+    char date[16];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+
+    std::cout << engines[0].name << " vs " << engines[1].name << ": " << rounds << " rounds, " << control.toString()
+              << ", " << concurrency << " threads, seed " << seed << std::endl;
+
+    const Sprt sprt(elo0, elo1);
+    // net result of every round for engine 1 (+3, 0 while it hasn't been played), like the ga2 fitness games
+    std::vector<std::atomic<int>> roundResults(rounds);
+    std::atomic<int> wins{0};
+    std::atomic<int> losses{0};
+    std::atomic<int> draws{0};
+    std::atomic<bool> stopped{false};
+    std::atomic<size_t> finished{0};
+    std::mutex doneMutex; // guards the pgn file and wakes up the reporting below
+    std::condition_variable doneCv;
+
+    // every finished round, for the running score
+    auto finishedCounts = [&]() {
+        Sprt::Pentanomial counts = {};
+        for (size_t r = 0; r < rounds; r++) {
+            const int result = roundResults[r].load();
+            if (result != 0) {
+                counts[result - 1]++;
+            }
+        }
+        return counts;
+    };
+
+    // runs the test over the rounds in order, up to the first one that isn't finished
+    auto sequentialTest = [&](Sprt::Pentanomial& counts) {
+        counts = {};
+        for (size_t r = 0; r < rounds; r++) {
+            const int result = roundResults[r].load();
+            if (result == 0) {
+                break;
+            }
+            counts[result - 1]++;
+            const Sprt::Decision decision = sprt.decide(counts);
+            if (useSprt && decision != Sprt::NONE) {
+                return decision;
+            }
+        }
+        return Sprt::NONE;
+    };
+
+    // the board and two searchers a worker plays all its games with
+    struct GameSlot {
+        Board board;
+        Searcher2 first;
+        Searcher2 second;
+
+        GameSlot(const EngineConfig* engines, size_t ttEntries)
+            : first(board, engines[0].search, engines[0].eval, ttEntries), second(board, engines[1].search, engines[1].eval, ttEntries) {
+            first.setVerbose(false);
+            second.setVerbose(false);
+        }
+    };
+
+    // the main thread only waits and reports, so exactly concurrency games run at once
+    ThreadPool pool(concurrency);
+    const size_t ttEntries = TranspositionTable::entriesForMegabytes(hashMegabytes);
+    auto start = std::chrono::high_resolution_clock::now();
+    // workers take their newest task first, so submitting the last round first gets the rounds played
+    // roughly in order, which is the order the sprt needs them in
+    for (size_t r = rounds; r-- > 0;) {
+        pool.submit([&, r]() {
+            if (!stopped.load()) {
+                static thread_local std::unique_ptr<GameSlot> slot;
+                if (!slot) {
+                    slot = std::make_unique<GameSlot>(engines, ttEntries);
+                }
+                GameRecord firstWhite = playGame(slot->first, slot->second, slot->board, openings[r], control);
+                GameRecord firstBlack = playGame(slot->second, slot->first, slot->board, openings[r], control);
+                const int net = firstWhite.result - firstBlack.result;
+                for (int result : {firstWhite.result, -firstBlack.result}) {
+                    (result > 0 ? wins : result < 0 ? losses : draws)++;
+                }
+                roundResults[r].store(net + 3);
+
+                Sprt::Pentanomial counts;
+                if (sequentialTest(counts) != Sprt::NONE) {
+                    stopped.store(true);
+                }
+                std::lock_guard<std::mutex> lock(doneMutex);
+                if (pgnFile) {
+                    const std::string tc = control.hasClock() ? control.toString() : "-";
+                    pgnFile << toPgn(firstWhite, engines[0].name, engines[1].name, std::to_string(r + 1) + ".1", tc, date)
+                            << toPgn(firstBlack, engines[1].name, engines[0].name, std::to_string(r + 1) + ".2", tc, date);
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                finished++;
+            }
+            doneCv.notify_one();
+        });
+    }
+
+    auto report = [&]() {
+        const int w = wins.load();
+        const int l = losses.load();
+        const int d = draws.load();
+        const int games = w + l + d;
+        const Sprt::Pentanomial counts = finishedCounts();
+        double elo, margin;
+        estimateElo(counts, elo, margin);
+        std::cout << "Score of " << engines[0].name << " vs " << engines[1].name << ": " << w << " - " << l << " - " << d
+                  << " [" << std::fixed << std::setprecision(3) << (games ? (w + 0.5 * d) / games : 0.0) << "] " << games << std::endl;
+        std::cout << "Elo difference: " << std::setprecision(1) << elo << " +/- " << margin;
+        if (useSprt) {
+            std::cout << ", SPRT llr " << std::setprecision(2) << sprt.llr(counts)
+                      << " (" << sprt.lowerBound() << ", " << sprt.upperBound() << ")";
+        }
+        std::cout << std::endl;
+    };
+
+    size_t reported = 0;
+    {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        while (finished.load() < rounds) {
+            doneCv.wait(lock, [&]() { return finished.load() == rounds || finished.load() >= reported + ratingInterval; });
+            if (finished.load() >= reported + ratingInterval && finished.load() < rounds) {
+                reported = finished.load();
+                report();
+            }
+        }
+    }
+    pool.wait();
+
+    Sprt::Pentanomial ordered;
+    const Sprt::Decision decision = sequentialTest(ordered);
+    const Sprt::Pentanomial counts = finishedCounts();
+    report();
+    const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "pentanomial [" << counts[0] << ", " << counts[1] << ", " << counts[2] << ", " << counts[3] << ", " << counts[4] << "], "
+              << 2 * Sprt::pairs(counts) << " games in " << std::setprecision(1) << seconds << " s" << std::endl;
+    if (useSprt) {
+        std::cout << "SPRT: " << (decision == Sprt::H1 ? "H1 accepted, " + engines[0].name + " is better"
+                                 : decision == Sprt::H0 ? "H0 accepted, " + engines[0].name + " is not better"
+                                 : std::string("no decision"))
+                  << " after " << Sprt::pairs(ordered) << " rounds, llr " << std::setprecision(2) << sprt.llr(ordered) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+// checks that a searcher reused through newGame() searches exactly like a freshly made one
+// the ga2 game slots, suite_runner and match all reuse searchers per thread and count on this
+// to give the same results for any thread count or order
+//   g++ -std=c++17 -O3 -march=native -pthread reuse_check.cpp -o reuse_check
+//   ./reuse_check ../../dbs/data_files/endgame_suite.csv 200 6
+// exits with 1 (and prints the positions) if any move or node count differs
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../engine/chess.hpp"
+#include "../engine/searcher2.hpp"
+#include "../engine/ga3and5results.hpp"
+#include "../engine/ga1results.hpp"
+
+using namespace chess;
+
+int main(int argc, char* argv[]) {
+    const std::string path = argc > 1 ? argv[1] : "../../dbs/data_files/endgame_suite.csv";
+    const size_t count = argc > 2 ? std::stoul(argv[2]) : 200;
+    const int depth = argc > 3 ? std::stoi(argv[3]) : 6;
+    const size_t ttEntries = 1 << 18;
+
+    std::vector<std::string> fens;
+    std::ifstream file(path);
+    std::string line;
+    while (fens.size() < count && std::getline(file, line)) {
+        const size_t comma = line.find(',');
+        if (line.find('/') != std::string::npos) {
+            fens.push_back(line.substr(0, comma));
+        }
+    }
+    if (fens.empty()) {
+        std::cerr << "no positions in " << path << std::endl;
+        return 2;
+    }
+
+    Board reusedBoard;
+    Searcher2 reused(reusedBoard, resultX2, ga1result10, ttEntries);
+    reused.setVerbose(false);
+
+    int mismatches = 0;
+    for (const std::string& fen : fens) {
+        reusedBoard.setFen(fen);
+        reused.newGame();
+        SearchState a = reused.fixedSearch(depth, 0);
+
+        Board freshBoard(fen);
+        Searcher2 fresh(freshBoard, resultX2, ga1result10, ttEntries);
+        fresh.setVerbose(false);
+        SearchState b = fresh.fixedSearch(depth, 0);
+
+        if (a.bestMove != b.bestMove || a.nodes != b.nodes || a.bestScore != b.bestScore) {
+            mismatches++;
+            std::cout << "differs: " << fen << " | reused " << uci::moveToUci(a.bestMove) << " " << a.nodes
+                      << " | fresh " << uci::moveToUci(b.bestMove) << " " << b.nodes << std::endl;
+        }
+    }
+    std::cout << fens.size() - mismatches << "/" << fens.size() << " positions searched the same" << std::endl;
+    return mismatches ? 1 : 0;
+}
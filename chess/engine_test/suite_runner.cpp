@@ -0,0 +1,348 @@
+// runs a whole test suite of positions with known best moves, several positions at a time
+// reads csv files like dbs/data_files/test_suite.csv (fen,best move in uci, several moves separated by spaces)
+// and epd files (bm/am in san or uci, the id is kept for the report), e.g.
+//   g++ -std=c++17 -O3 -march=native -pthread suite_runner.cpp -o suite_runner
+//   ./suite_runner ../../dbs/data_files/test_suite.csv --nodes 200000
+//   ./suite_runner ../../dbs/data_files/endgame_suite.csv --time 500 --threads 4 --missed
+// every worker thread has its own board and Searcher2, and newGame() resets it before each position
+// (tt, pv and killers, see reuse_check.cpp), so with --depth or --nodes the results don't depend on the
+// thread count or the order of the suite, only --time does
+// a position counts as solved when the move of the last finished depth is a best move (or not an avoid move)
+// time/nodes/depth to solution are from the first depth after which the move stayed right
+// --min-solved n makes the exit code 1 when fewer than n positions are solved, for use as a regression gate
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <iomanip>
+#include "../engine/chess.hpp"
+#include "../engine/searcher2.hpp"
+#include "../engine/ga3and5results.hpp"
+#include "../engine/ga1results.hpp"
+
+using namespace chess;
+
+struct SuitePosition {
+    std::string id;
+    std::string fen;
+    std::vector<Move> bestMoves;
+    std::vector<Move> avoidMoves;
+    std::string expected; // the moves as written in the suite, for the report
+
+    bool isCorrect(Move move) const {
+        if (!bestMoves.empty()) {
+            return std::find(bestMoves.begin(), bestMoves.end(), move) != bestMoves.end();
+        }
+        return std::find(avoidMoves.begin(), avoidMoves.end(), move) == avoidMoves.end();
+    }
+};
+
+struct SuiteResult {
+    Move found = Move::NO_MOVE;
+    bool solved = false;
+    int depth = 0;
+    long nodes = 0;
+    long ms = 0;
+    // where the right move was found for good, only meaningful when solved
+    int solveDepth = -1;
+    long solveNodes = -1;
+    long solveMs = -1;
+};
+
+struct Limits {
+    int depth = 0;
+    long nodes = 0;
+    int ms = 0;
+};
+
+std::string trim(const std::string& s) {
+    const size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+// a move in uci or san, NO_MOVE if it isn't legal here
+Move parseMove(const Board& board, const std::string& text) {
+    Movelist legal;
+    movegen::legalmoves<MoveGenType::ALL>(legal, board);
+    Move move = Move::NO_MOVE;
+    if (text.size() >= 4 && text.size() <= 5 && text[0] >= 'a' && text[0] <= 'h' && text[1] >= '1' && text[1] <= '8'
+        && text[2] >= 'a' && text[2] <= 'h' && text[3] >= '1' && text[3] <= '8') {
+        move = uci::uciToMove(board, text);
+    }
+    else {
+        try {
+            move = uci::parseSan(board, text);
+        }
+        catch (...) {
+            return Move::NO_MOVE;
+        }
+    }
+    return std::find(legal.begin(), legal.end(), move) != legal.end() ? move : Move::NO_MOVE;
+}
+
+// the moves of one operand list, false if any of them is not a legal move
+bool parseMoves(const Board& board, const std::string& text, std::vector<Move>& moves) {
+    std::istringstream stream(text);
+    std::string token;
+    while (stream >> token) {
+        Move move = parseMove(board, token);
+        if (move == Move::NO_MOVE) {
+            return false;
+        }
+        moves.push_back(move);
+    }
+    return !moves.empty();
+}
+
+// fen,moves
+bool parseCsvLine(const std::string& line, SuitePosition& position) {
+    const size_t comma = line.rfind(',');
+    if (comma == std::string::npos) {
+        return false;
+    }
+    position.fen = trim(line.substr(0, comma));
+    position.expected = trim(line.substr(comma + 1));
+    Board board(position.fen);
+    return parseMoves(board, position.expected, position.bestMoves);
+}
+
+// the four fen fields followed by operations like: bm Nf3 Qd2; am e4; id "name";
+bool parseEpdLine(const std::string& line, SuitePosition& position) {
+    std::istringstream stream(line);
+    std::string fields[4];
+    for (std::string& field : fields) {
+        if (!(stream >> field)) {
+            return false;
+        }
+    }
+    position.fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+    Board board(position.fen);
+
+    std::string rest;
+    std::getline(stream, rest);
+    std::istringstream operations(rest);
+    std::string operation;
+    while (std::getline(operations, operation, ';')) {
+        operation = trim(operation);
+        const size_t space = operation.find(' ');
+        if (space == std::string::npos) {
+            continue;
+        }
+        const std::string opcode = operation.substr(0, space);
+        const std::string operands = trim(operation.substr(space + 1));
+        if (opcode == "bm" || opcode == "am") {
+            if (!parseMoves(board, operands, opcode == "bm" ? position.bestMoves : position.avoidMoves)) {
+                return false;
+            }
+            position.expected += (position.expected.empty() ? "" : " ") + opcode + " " + operands;
+        }
+        else if (opcode == "id") {
+            position.id = operands;
+            position.id.erase(std::remove(position.id.begin(), position.id.end(), '"'), position.id.end());
+        }
+    }
+    return !position.bestMoves.empty() || !position.avoidMoves.empty();
+}
+
+std::vector<SuitePosition> loadSuite(const std::string& path) {
+    std::vector<SuitePosition> suite;
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "could not open " << path << std::endl;
+        return suite;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        SuitePosition position;
+        const bool isEpd = line.find(" bm ") != std::string::npos || line.find(" am ") != std::string::npos;
+        if (!(isEpd ? parseEpdLine(line, position) : parseCsvLine(line, position))) {
+            std::cerr << "skipping line " << lineNumber << ": " << line << std::endl;
+            continue;
+        }
+        if (position.id.empty()) {
+            position.id = std::to_string(lineNumber);
+        }
+        suite.push_back(position);
+    }
+    return suite;
+}
+
+SuiteResult solve(Searcher2& searcher, Board& board, const SuitePosition& position, const Limits& limits) {
+    SuiteResult result;
+    board.setFen(position.fen);
+    searcher.newGame();
+    searcher.setIterationCallback([&](const SearchState& state, long ms) {
+        if (!position.isCorrect(state.bestMove)) {
+            result.solveDepth = -1;
+        }
+        else if (result.solveDepth < 0) {
+            result.solveDepth = state.currentDepth;
+            result.solveNodes = state.nodes;
+            result.solveMs = ms;
+        }
+    });
+
+    auto start = std::chrono::high_resolution_clock::now();
+    SearchState state = searcher.fixedSearch(limits.depth, limits.nodes, limits.ms);
+    result.ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    result.found = state.bestMove;
+    result.depth = state.currentDepth;
+    result.nodes = state.nodes;
+    result.solved = position.isCorrect(state.bestMove) && result.solveDepth >= 0;
+    return result;
+}
+
+// min, quartiles, 90th percentile and max of the solved positions
+template <typename T>
+void printDistribution(const std::string& name, std::vector<T> values) {
+    if (values.empty()) {
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&values](double q) { return values[std::min(values.size() - 1, size_t(q * values.size()))]; };
+    double mean = 0;
+    for (T value : values) {
+        mean += value;
+    }
+    mean /= values.size();
+    std::cout << std::left << std::setw(20) << name << std::right
+              << " min " << values.front() << "  p25 " << at(0.25) << "  median " << at(0.5)
+              << "  p75 " << at(0.75) << "  p90 " << at(0.9) << "  max " << values.back()
+              << "  mean " << std::fixed << std::setprecision(1) << mean << std::endl;
+}
+
+void usage() {
+    std::cerr << "usage: suite_runner <suite.csv|suite.epd> [--depth n] [--nodes n] [--time ms] [--threads n]"
+              << " [--hash mb] [--first n] [--missed] [--min-solved n]" << std::endl
+              << "without a depth, node or time limit every position gets 1000 ms" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+    const std::string path = argv[1];
+    Limits limits;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t hashMegabytes = 16;
+    size_t first = 0;
+    bool showMissed = false;
+    int minSolved = -1;
+
+    for (int i = 2; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--depth" && hasValue) {
+            limits.depth = std::stoi(argv[++i]);
+        } else if (arg == "--nodes" && hasValue) {
+            limits.nodes = std::stol(argv[++i]);
+        } else if (arg == "--time" && hasValue) {
+            limits.ms = std::stoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--hash" && hasValue) {
+            hashMegabytes = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--first" && hasValue) {
+            first = std::stoul(argv[++i]);
+        } else if (arg == "--missed") {
+            showMissed = true;
+        } else if (arg == "--min-solved" && hasValue) {
+            minSolved = std::stoi(argv[++i]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!limits.depth && !limits.nodes && !limits.ms) {
+        limits.ms = 1000;
+    }
+
+    std::vector<SuitePosition> suite = loadSuite(path);
+    if (first && first < suite.size()) {
+        suite.resize(first);
+    }
+    if (suite.empty()) {
+        std::cerr << "no positions in " << path << std::endl;
+        return 2;
+    }
+    threads = std::min<unsigned>(threads, suite.size());
+
+    std::cout << "suite " << path << ": " << suite.size() << " positions, " << threads << " threads, limits:"
+              << (limits.depth ? " depth " + std::to_string(limits.depth) : "")
+              << (limits.nodes ? " nodes " + std::to_string(limits.nodes) : "")
+              << (limits.ms ? " time " + std::to_string(limits.ms) + " ms" : "") << std::endl;
+
+    // every worker takes the next unsolved position until there are none left
+    std::vector<SuiteResult> results(suite.size());
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            Board board;
+            auto searcher = std::make_unique<Searcher2>(board, resultX2, ga1result10, TranspositionTable::entriesForMegabytes(hashMegabytes));
+            searcher->setVerbose(false);
+            for (size_t i = next.fetch_add(1); i < suite.size(); i = next.fetch_add(1)) {
+                results[i] = solve(*searcher, board, suite[i], limits);
+                const size_t finished = done.fetch_add(1) + 1;
+                if (finished % 50 == 0) {
+                    std::cerr << finished << "/" << suite.size() << " done" << std::endl;
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double wallSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    int solved = 0;
+    long totalNodes = 0;
+    long totalMs = 0;
+    std::vector<long> solveMs;
+    std::vector<long> solveNodes;
+    std::vector<int> solveDepth;
+    for (size_t i = 0; i < suite.size(); i++) {
+        const SuiteResult& result = results[i];
+        totalNodes += result.nodes;
+        totalMs += result.ms;
+        if (result.solved) {
+            solved++;
+            solveMs.push_back(result.solveMs);
+            solveNodes.push_back(result.solveNodes);
+            solveDepth.push_back(result.solveDepth);
+        }
+        else if (showMissed) {
+            std::cout << "missed " << suite[i].id << ": " << suite[i].fen << " | expected " << suite[i].expected
+                      << " | played " << uci::moveToUci(result.found) << " (depth " << result.depth << ")" << std::endl;
+        }
+    }
+
+    std::cout << "solved " << solved << "/" << suite.size() << " ("
+              << std::fixed << std::setprecision(1) << 100.0 * solved / suite.size() << "%)" << std::endl;
+    printDistribution("time to solution ms", solveMs);
+    printDistribution("nodes to solution", solveNodes);
+    printDistribution("depth to solution", solveDepth);
+    std::cout << "total nodes " << totalNodes << ", search time " << totalMs << " ms, "
+              << static_cast<long>(totalNodes / (totalMs / 1000.0 + 1e-9)) << " nps per thread, wall time "
+              << std::setprecision(2) << wallSeconds << " s" << std::endl;
+
+    return minSolved >= 0 && solved < minSolved ? 1 : 0;
+}
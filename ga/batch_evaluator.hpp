@@ -0,0 +1,137 @@
+// scores a whole training set against one TunableEval at once, for the tuner
+// the evaluation is linear in the weights (see EvalFeatures), so the bitboard work is done once
+// per position when it is added, and scoring a candidate is two dot products per position
+// the counts are stored one column per feature (structure of arrays) so 8 positions
+// can be scored at a time with AVX2
+#pragma once
+#include <vector>
+#include <string>
+#include <cmath>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "../chess/engine/evaluator.hpp"
+#include "packed_position.hpp"
+#include "../chess/engine/chess.hpp"
+
+using namespace chess;
+
+class BatchEvaluator {
+public:
+    static const int COLUMNS = EvalFeatures::MATERIAL + EvalFeatures::TERMS;
+
+    BatchEvaluator() : evaluator(board) {}
+
+    void clear() {
+        for (std::vector<float>& column : columns) {
+            column.clear();
+        }
+        phases.clear();
+        scales.clear();
+    }
+
+    void reserve(size_t n) {
+        for (std::vector<float>& column : columns) {
+            column.reserve(n);
+        }
+        phases.reserve(n);
+        scales.reserve(n);
+    }
+
+    // positions a specialized endgame scores are left out, their eval doesn't depend on the weights
+    // returns whether the position was added
+    bool add(const EvalFeatures& f) {
+        if (f.specialized) {
+            return false;
+        }
+        for (int i = 0; i < EvalFeatures::MATERIAL; i++) {
+            columns[i].push_back(f.material[i]);
+        }
+        for (int i = 0; i < EvalFeatures::TERMS; i++) {
+            columns[EvalFeatures::MATERIAL + i].push_back(f.terms[i]);
+        }
+        phases.push_back(f.gamePhase);
+        scales.push_back(f.scale);
+        return true;
+    }
+
+    bool add(const std::string& fen) {
+        board.setFen(fen);
+        return add(evaluator.features());
+    }
+
+    bool add(const PackedPosition& position) {
+        board.unpack(position);
+        return add(evaluator.features());
+    }
+
+    size_t size() const {
+        return phases.size();
+    }
+
+    // white relative evaluation of every position, same as Evaluator::evaluate up to float rounding
+    // (which holds because the positions a specialized endgame scores never get added)
+    void evaluate(const TunableEval& weights, std::vector<float>& out) const {
+        float mgWeights[COLUMNS];
+        float egWeights[COLUMNS];
+        for (int i = 0; i < COLUMNS; i++) {
+            const GamePhaseValue& weight = i < EvalFeatures::MATERIAL
+                ? weights.*MATERIAL_WEIGHTS[i]
+                : weights.*TERM_WEIGHTS[i - EvalFeatures::MATERIAL];
+            mgWeights[i] = weight.middleGame;
+            egWeights[i] = weight.endGame;
+        }
+
+        const size_t n = size();
+        out.resize(n);
+        size_t p = 0;
+
+#ifdef __AVX2__
+        const __m256 one = _mm256_set1_ps(1.0f);
+        for (; p + 8 <= n; p += 8) {
+            __m256 mg = _mm256_setzero_ps();
+            __m256 eg = _mm256_setzero_ps();
+            for (int i = 0; i < COLUMNS; i++) {
+                const __m256 counts = _mm256_loadu_ps(&columns[i][p]);
+                mg = _mm256_add_ps(mg, _mm256_mul_ps(counts, _mm256_set1_ps(mgWeights[i])));
+                eg = _mm256_add_ps(eg, _mm256_mul_ps(counts, _mm256_set1_ps(egWeights[i])));
+            }
+            const __m256 phase = _mm256_loadu_ps(&phases[p]);
+            const __m256 score = _mm256_add_ps(_mm256_mul_ps(mg, phase), _mm256_mul_ps(eg, _mm256_sub_ps(one, phase)));
+            _mm256_storeu_ps(&out[p], _mm256_mul_ps(score, _mm256_loadu_ps(&scales[p])));
+        }
+#endif
+
+        // whatever is left over (or everything, without AVX2)
+        for (; p < n; p++) {
+            float mg = 0;
+            float eg = 0;
+            for (int i = 0; i < COLUMNS; i++) {
+                mg += columns[i][p] * mgWeights[i];
+                eg += columns[i][p] * egWeights[i];
+            }
+            out[p] = (mg * phases[p] + eg * (1 - phases[p])) * scales[p];
+        }
+    }
+
+    // average absolute difference to the target evaluations, what the ga uses as fitness
+    // safe to call from several threads at once
+    double meanAbsoluteError(const TunableEval& weights, const std::vector<double>& targets) const {
+        std::vector<float> scores;
+        evaluate(weights, scores);
+        double totalDifference = 0.0;
+        for (size_t i = 0; i < scores.size(); i++) {
+            totalDifference += std::abs(scores[i] - targets[i]);
+        }
+        return scores.empty() ? 0.0 : totalDifference / scores.size();
+    }
+
+private:
+    std::vector<float> columns[COLUMNS];
+    std::vector<float> phases;
+    std::vector<float> scales; // endgame scale, 1 unless the material is drawish
+
+    // only used to extract features from fens and packed positions
+    PackedBoard board;
+    Evaluator evaluator;
+};
@@ -0,0 +1,29 @@
+// turns a fen,eval csv into a feature matrix (see feature_matrix.hpp), so the tuners can skip the boards
+// usage: ./extractFeatures ../dbs/data_files/stockfish11.csv stockfish11.bin
+#include <iostream>
+#include <chrono>
+#include "feature_matrix.hpp"
+#include "../chess/engine/baselines.hpp"
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "usage: " << argv[0] << " <input.csv> <output.bin>" << std::endl;
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    FeatureMatrix matrix;
+    size_t rows = matrix.addCSV(argv[1]);
+    matrix.save(argv[2]);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Extracted " << rows << " positions in " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms" << std::endl;
+
+    // read it back, the baseline fitness should match what the ga prints for the same csv
+    FeatureMatrix loaded;
+    loaded.load(argv[2]);
+    begin = std::chrono::steady_clock::now();
+    double fitness = loaded.meanAbsoluteError(baseEval);
+    end = std::chrono::steady_clock::now();
+    std::cout << "Baseline Fitness: " << fitness << " (" << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << " us)" << std::endl;
+    return loaded.size() == rows ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+// the training set with the features already extracted, so tuning never has to touch a board
+// extractFeatures.cpp turns a fen,eval csv into a .bin once, and every tuner run after that just loads it
+//
+// most feature counts are zero in any given position, so the rows are stored sparse (compressed rows):
+// only the nonzero (column, count) pairs, with the game phase, the endgame scale and the target eval
+// the mg/eg split is not stored, it follows from the phase: the mg weight of a column gets
+// count * phase and the eg weight gets count * (1 - phase), exactly as in Evaluator::score,
+// and the sum is multiplied with the scale like Evaluator::evaluate does
+//
+// file layout (little endian):
+//   "GFM2", uint32 columns, uint64 rows
+//   then per row: float target, float phase, float scale, uint8 nonzeros, nonzeros * (uint8 column, int8 count)
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <stdexcept>
+#include "../chess/engine/evaluator.hpp"
+#include "../chess/engine/chess.hpp"
+
+using namespace chess;
+
+class FeatureMatrix {
+public:
+    static const int COLUMNS = EvalFeatures::MATERIAL + EvalFeatures::TERMS;
+
+    FeatureMatrix() {
+        rowStart.push_back(0);
+    }
+
+    size_t size() const {
+        return targets.size();
+    }
+
+    bool empty() const {
+        return targets.empty();
+    }
+
+    // positions a specialized endgame scores are left out, nothing in them depends on the weights
+    // returns whether the row was added
+    bool add(const EvalFeatures& f, float target) {
+        if (f.specialized) {
+            return false;
+        }
+        for (int i = 0; i < COLUMNS; i++) {
+            int count = i < EvalFeatures::MATERIAL ? f.material[i] : f.terms[i - EvalFeatures::MATERIAL];
+            if (count == 0) {
+                continue;
+            }
+            if (count < INT8_MIN || count > INT8_MAX) {
+                throw std::out_of_range("feature count does not fit in a byte");
+            }
+            columns.push_back(static_cast<uint8_t>(i));
+            counts.push_back(static_cast<int8_t>(count));
+        }
+        rowStart.push_back(static_cast<uint32_t>(columns.size()));
+        phases.push_back(f.gamePhase);
+        scales.push_back(f.scale);
+        targets.push_back(target);
+        return true;
+    }
+
+    // reads fen,eval lines (anything that doesn't parse, like a header, is skipped)
+    // returns the number of positions added
+    size_t addCSV(const std::string& filename) {
+        std::ifstream file(filename);
+        if (!file) {
+            throw std::runtime_error("could not open " + filename);
+        }
+
+        Board board;
+        Evaluator evaluator(board);
+        std::string line;
+        size_t added = 0;
+        while (std::getline(file, line)) {
+            std::stringstream ss(line);
+            std::string fen;
+            double score;
+            if (std::getline(ss, fen, ',') && ss >> score) {
+                board.setFen(fen);
+                if (add(evaluator.features(), static_cast<float>(score))) {
+                    added++;
+                }
+            }
+        }
+        return added;
+    }
+
+    EvalFeatures row(size_t r) const {
+        EvalFeatures f;
+        for (uint32_t k = rowStart[r]; k < rowStart[r + 1]; k++) {
+            if (columns[k] < EvalFeatures::MATERIAL) {
+                f.material[columns[k]] = counts[k];
+            }
+            else {
+                f.terms[columns[k] - EvalFeatures::MATERIAL] = counts[k];
+            }
+        }
+        f.gamePhase = phases[r];
+        f.scale = scales[r];
+        return f;
+    }
+
+    float target(size_t r) const {
+        return targets[r];
+    }
+
+    float phase(size_t r) const {
+        return phases[r];
+    }
+
+    float scale(size_t r) const {
+        return scales[r];
+    }
+
+    // calls f(column, count) for each nonzero feature of row r
+    template <typename F>
+    void forEachFeature(size_t r, F&& f) const {
+        for (uint32_t k = rowStart[r]; k < rowStart[r + 1]; k++) {
+            f(columns[k], counts[k]);
+        }
+    }
+
+    // the mg and eg weight of every column, in column order
+    static void weightVectors(const TunableEval& weights, float mgWeights[COLUMNS], float egWeights[COLUMNS]) {
+        for (int i = 0; i < COLUMNS; i++) {
+            const GamePhaseValue& weight = i < EvalFeatures::MATERIAL
+                ? weights.*MATERIAL_WEIGHTS[i]
+                : weights.*TERM_WEIGHTS[i - EvalFeatures::MATERIAL];
+            mgWeights[i] = weight.middleGame;
+            egWeights[i] = weight.endGame;
+        }
+    }
+
+    // white relative eval of row r, a sparse dot product with each weight vector
+    float evaluate(size_t r, const float mgWeights[COLUMNS], const float egWeights[COLUMNS]) const {
+        float mg = 0;
+        float eg = 0;
+        for (uint32_t k = rowStart[r]; k < rowStart[r + 1]; k++) {
+            mg += counts[k] * mgWeights[columns[k]];
+            eg += counts[k] * egWeights[columns[k]];
+        }
+        return (mg * phases[r] + eg * (1 - phases[r])) * scales[r];
+    }
+
+    // same fitness the ga uses, over every row
+    double meanAbsoluteError(const TunableEval& weights) const {
+        float mgWeights[COLUMNS];
+        float egWeights[COLUMNS];
+        weightVectors(weights, mgWeights, egWeights);
+
+        double totalDifference = 0.0;
+        for (size_t r = 0; r < size(); r++) {
+            totalDifference += std::abs(evaluate(r, mgWeights, egWeights) - targets[r]);
+        }
+        return empty() ? 0.0 : totalDifference / size();
+    }
+
+    void save(const std::string& filename) const {
+        std::ofstream out(filename, std::ios::binary);
+        if (!out) {
+            throw std::runtime_error("could not write " + filename);
+        }
+        const uint32_t columnCount = COLUMNS;
+        const uint64_t rows = size();
+        out.write(MAGIC, 4);
+        out.write(reinterpret_cast<const char*>(&columnCount), sizeof(columnCount));
+        out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+
+        for (size_t r = 0; r < size(); r++) {
+            const uint8_t nonzeros = static_cast<uint8_t>(rowStart[r + 1] - rowStart[r]);
+            out.write(reinterpret_cast<const char*>(&targets[r]), sizeof(float));
+            out.write(reinterpret_cast<const char*>(&phases[r]), sizeof(float));
+            out.write(reinterpret_cast<const char*>(&scales[r]), sizeof(float));
+            out.write(reinterpret_cast<const char*>(&nonzeros), 1);
+            for (uint32_t k = rowStart[r]; k < rowStart[r + 1]; k++) {
+                out.write(reinterpret_cast<const char*>(&columns[k]), 1);
+                out.write(reinterpret_cast<const char*>(&counts[k]), 1);
+            }
+        }
+    }
+
+    void load(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        char magic[4];
+        uint32_t columnCount = 0;
+        uint64_t rows = 0;
+        in.read(magic, 4);
+        in.read(reinterpret_cast<char*>(&columnCount), sizeof(columnCount));
+        in.read(reinterpret_cast<char*>(&rows), sizeof(rows));
+        if (!in || std::memcmp(magic, MAGIC, 4) != 0) {
+            throw std::runtime_error(filename + " is not a feature matrix (or is from before the endgame scale was stored), rerun extractFeatures");
+        }
+        // the columns follow TunableEval, so a file from an older evaluator can't be mixed in
+        if (columnCount != COLUMNS) {
+            throw std::runtime_error(filename + " was extracted with a different set of features, rerun extractFeatures");
+        }
+
+        *this = FeatureMatrix();
+        targets.reserve(rows);
+        phases.reserve(rows);
+        scales.reserve(rows);
+        rowStart.reserve(rows + 1);
+        for (uint64_t r = 0; r < rows; r++) {
+            float target, phase, scale;
+            uint8_t nonzeros;
+            in.read(reinterpret_cast<char*>(&target), sizeof(float));
+            in.read(reinterpret_cast<char*>(&phase), sizeof(float));
+            in.read(reinterpret_cast<char*>(&scale), sizeof(float));
+            in.read(reinterpret_cast<char*>(&nonzeros), 1);
+            for (int k = 0; k < nonzeros; k++) {
+                uint8_t column;
+                int8_t count;
+                in.read(reinterpret_cast<char*>(&column), 1);
+                in.read(reinterpret_cast<char*>(&count), 1);
+                columns.push_back(column);
+                counts.push_back(count);
+            }
+            if (!in) {
+                throw std::runtime_error(filename + " is truncated");
+            }
+            rowStart.push_back(static_cast<uint32_t>(columns.size()));
+            phases.push_back(phase);
+            scales.push_back(scale);
+            targets.push_back(target);
+        }
+    }
+
+private:
+    static constexpr const char* MAGIC = "GFM2";
+
+    std::vector<uint32_t> rowStart; // row r is [rowStart[r], rowStart[r + 1])
+    std::vector<uint8_t> columns;
+    std::vector<int8_t> counts;
+    std::vector<float> phases;
+    std::vector<float> scales;
+    std::vector<float> targets;
+};
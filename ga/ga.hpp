@@ -8,7 +8,11 @@
 #include <thread>
 #include <vector>
 #include <mutex>
+#include <numeric>
 #include "ga_util.hpp"
+#include "batch_evaluator.hpp"
+#include "feature_matrix.hpp"
+#include "thread_pool.hpp"
 #include "../chess/engine/baselines.hpp"
 #include "../chess/engine/evaluator.hpp"
 #include "../chess/engine/chess.hpp"
@@ -22,7 +26,13 @@ class GeneticAlgorithm {
 public:
     GeneticAlgorithm(size_t populationSize, double initialMutationRate, double mutationDecayRate, double crossoverRate, int totalGenerations, int trainingSize, int eliteCount, int archiveSize, int reintroduceCount, std::string trainingDataPath)
         : populationSize(populationSize), initialMutationRate(initialMutationRate), mutationDecayRate(mutationDecayRate),  crossoverRate(crossoverRate),totalGenerations(totalGenerations), trainingSize(trainingSize), eliteCount(eliteCount), archiveSize(archiveSize), reintroduceCount(reintroduceCount), trainingDataPath(trainingDataPath){
-        readCSV(trainingDataPath); 
+        // a .bin from extractFeatures already has the features, a csv has to go through the evaluator
+        if (trainingDataPath.size() > 4 && trainingDataPath.substr(trainingDataPath.size() - 4) == ".bin") {
+            trainingFeatures.load(trainingDataPath);
+        }
+        else {
+            readCSV(trainingDataPath);
+        }
         selectNRandom(trainingSize); // Select 5,000 random evaluations
         initializePopulation();
         
@@ -37,9 +47,9 @@ public:
         //try baseline
         std::cout << "Training Data Path" << trainingDataPath << std::endl;
 
-        double baseline = calculateFitness(evaluations, baseEval);
+        double baseline = calculateFitness(baseEval);
         std::cout << "Baseline Fitness: " << baseline << std::endl;
-        double zeroBaseline = calculateFitness(evaluations, zeroEval);
+        double zeroBaseline = calculateFitness(zeroEval);
         std::cout << "Zero Fitness: " << zeroBaseline << std::endl;
 
         while(currentGeneration++ < totalGenerations) {
@@ -92,8 +102,9 @@ public:
 
 private:
     // for reading the csv file
+    // fens are parsed once when the csv is read, after that positions stay packed
     struct PositionEvaluation {
-        std::string fen;
+        PackedPosition position;
         double actualScore;
     };
 
@@ -120,8 +131,12 @@ private:
     std::vector<chromosome> population; // a vector of pairs of chromosomes and their fitness levels
     std::vector<PositionEvaluation> allEvaluations;
     std::vector<PositionEvaluation> evaluations;
+    FeatureMatrix trainingFeatures; // all positions, when training from a .bin instead of a csv
+    BatchEvaluator batch; // features of evaluations, for fitness
+    std::vector<double> targets; // actualScore of evaluations, in the same order
     std::random_device rd;
     std::mt19937 gen{rd()}; // random c++ magic stuff
+    ThreadPool& pool = ThreadPool::global();
     std::string trainingDataPath = "../dbs/quiet_evals_filtered";
 
     
@@ -129,13 +144,15 @@ private:
     void readCSV(const std::string& filename) {
         std::ifstream file(filename);
         std::string line;
+        Board board;
 
         while (std::getline(file, line)) {
             std::stringstream ss(line);
             std::string fen;
             double score;
             if (std::getline(ss, fen, ',') && ss >> score) {
-                allEvaluations.push_back({fen, score});
+                board.setFen(fen);
+                allEvaluations.push_back({PackedPosition::pack(board), score});
             }
         }
     }  
@@ -145,79 +162,75 @@ private:
         return initialRate * exp(-decayRate * generation);
     }
 
-    // Helper function to calculate fitness for a subset of evaluations
-double calculateFitnessSubset(const std::vector<PositionEvaluation>& evalsSubset, const TunableEval& params) {
-    double totalDifference = 0.0;
-    for (const auto& eval : evalsSubset) {
-        Board board = Board();
-        Evaluator evaluator = Evaluator(board, params);
-        board.setFen(eval.fen);
-        double predictedScore = evaluator.evaluate(false);
-        totalDifference += std::abs(predictedScore - eval.actualScore);
-    }
-    return totalDifference;
-}
-
-// Modified calculateFitness function with multi-threading
-// obviously I did not write this, but damn is it nice. x5 speedup more or less
-double calculateFitness(const std::vector<PositionEvaluation>& evals, const TunableEval& params) {
-    const size_t numThreads = std::thread::hardware_concurrency() - 1; // Use as many threads as there are CPU cores - 1
-    std::vector<std::thread> threads;
-    std::vector<double> partialDifferences(numThreads, 0.0); // To store the results from each thread
-
-    size_t evalsPerThread = evals.size() / numThreads;
-    
-    // Lambda to process each subset of evaluations
-   auto worker = [&](size_t startIdx, size_t endIdx, size_t threadIdx) {
-    try {
-        std::vector<PositionEvaluation> evalsSubset(evals.begin() + startIdx, evals.begin() + endIdx);
-        partialDifferences[threadIdx] = calculateFitnessSubset(evalsSubset, params);
-    } catch (const std::exception& e) {
-        std::cerr << "Exception in thread " << threadIdx << ": " << e.what() << std::endl;
-        // Handle exception or set an error state
+    // average absolute difference between our eval and the training evals
+    // the features of the selected positions are extracted once in selectNRandom,
+    // so this only has to apply the weights
+    double calculateFitness(const TunableEval& params) {
+        return batch.meanAbsoluteError(params, targets);
     }
-};
 
-
-    // Launch threads
-    for (size_t i = 0; i < numThreads; ++i) {
-        size_t startIdx = i * evalsPerThread;
-        size_t endIdx = (i + 1) * evalsPerThread;
-        if (i == numThreads - 1) {
-            endIdx = evals.size(); // Make sure the last thread covers all remaining evaluations
-        }
-        threads.emplace_back(worker, startIdx, endIdx, i);
-    }
-
-    // Wait for all threads to complete
-    for (auto& t : threads) {
-        t.join();
+    // fitness of the given individuals, spread over the thread pool
+    void calculateFitness(std::vector<chromosome>& individuals, const std::vector<size_t>& indices) {
+        pool.parallelFor(0, indices.size(), 8, [&](size_t i) {
+            chromosome& c = individuals[indices[i]];
+            c.fitness = calculateFitness(convertChromosoneToEval(c.chromosome));
+        });
     }
 
-    // Aggregate the results
-    double totalDifference = 0.0;
-    for (const auto& diff : partialDifferences) {
-        totalDifference += diff;
+    void calculateFitness(std::vector<chromosome>& individuals) {
+        std::vector<size_t> indices(individuals.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        calculateFitness(individuals, indices);
     }
 
-    return totalDifference / evals.size(); // Return the average difference
-}
-
     // looks good
     void initializePopulation() {
         for (size_t i = 0; i < populationSize; ++i) {
             TunableEval randomEval = initializeRandomTunableEval();
-            population.push_back({convertEvalToChromosone(randomEval), calculateFitness(evaluations, randomEval)}); // 100000.0 is a placeholder for the fitness level
+            population.push_back({convertEvalToChromosone(randomEval), 100000.0}); // 100000.0 is a placeholder for the fitness level
         }
+        calculateFitness(population);
     }
 
     void selectNRandom(size_t n) {
+        batch.clear();
+        batch.reserve(n);
+        targets.clear();
+
+        if (!trainingFeatures.empty()) {
+            std::uniform_int_distribution<size_t> dist(0, trainingFeatures.size() - 1);
+            while (targets.size() < n) {
+                size_t row = dist(gen);
+                batch.add(trainingFeatures.row(row));
+                targets.push_back(trainingFeatures.target(row));
+            }
+            return;
+        }
+
         evaluations.clear();
         std::uniform_int_distribution<> dist(0, allEvaluations.size() - 1);
         while (evaluations.size() < n) {
             evaluations.push_back(allEvaluations[dist(gen)]);
         }
-        
+
+        // feature extraction is the expensive part, each chunk gets its own board to unpack into
+        const size_t chunkSize = 64;
+        std::vector<EvalFeatures> features(evaluations.size());
+        pool.parallelFor(0, (evaluations.size() + chunkSize - 1) / chunkSize, 1, [&](size_t chunk) {
+            PackedBoard board;
+            Evaluator evaluator(board);
+            for (size_t i = chunk * chunkSize; i < std::min(evaluations.size(), (chunk + 1) * chunkSize); i++) {
+                board.unpack(evaluations[i].position);
+                features[i] = evaluator.features();
+            }
+        });
+
+        for (size_t i = 0; i < evaluations.size(); i++) {
+            if (batch.add(features[i])) {
+                targets.push_back(evaluations[i].actualScore);
+            }
+        }
+
     }
 
     // looks good
@@ -228,6 +241,8 @@ double calculateFitness(const std::vector<PositionEvaluation>& evals, const Tuna
             // flip the bit at that point
             mutate(individual); // first is the chromosome
         }
+        // recalculate the fitness levels
+        calculateFitness(population);
     }
 
     // Function to perform single-point crossover between two chromosomes
@@ -305,6 +320,7 @@ chromosome rouletteWheelSelectionWithScaling(const std::vector<chromosome>& pare
 void crossover() {
     // Clear the population to prepare for the new generation
     std::vector<chromosome> newPopulation;
+    std::vector<size_t> children; // indices in newPopulation that still need a fitness
 
     std::uniform_int_distribution<> parentDist(0, population.size() - 1); // Distribution for selecting parents
 
@@ -318,10 +334,12 @@ void crossover() {
             // Perform single-point crossover
             auto [child1, child2] = singlePointCrossover(parent1.chromosome, parent2.chromosome);
 
-            // Calculate fitness for the new children and add them to the new population
-            newPopulation.push_back({child1, calculateFitness(evaluations, convertChromosoneToEval(child1))});
+            // Add the new children to the new population, their fitness is calculated below
+            children.push_back(newPopulation.size());
+            newPopulation.push_back({child1, 0.0});
             if (newPopulation.size() < populationSize) { // Check to avoid exceeding population size
-                newPopulation.push_back({child2, calculateFitness(evaluations, convertChromosoneToEval(child2))});
+                children.push_back(newPopulation.size());
+                newPopulation.push_back({child2, 0.0});
             }
         } else {
             // If crossover does not occur, copy parents to the new population, checking not to exceed the population size
@@ -334,6 +352,8 @@ void crossover() {
         }
     }
 
+    calculateFitness(newPopulation, children);
+
     // Update the original population with the new one
     population = std::move(newPopulation);
 }
@@ -431,8 +451,6 @@ void crossover() {
                 
             }
         }
-        // recalculate the fitness level
-        c.fitness = calculateFitness(evaluations, convertChromosoneToEval(c.chromosome));
         }
 
     };
@@ -10,8 +10,12 @@
 #include <numeric>
 #include <iostream>
 #include <cassert>
+#include <array>
+#include <memory>
 #include "logger.hpp"
 #include "ga_util.hpp"
+#include "thread_pool.hpp"
+#include "sprt.hpp"
 #include "../chess/engine/ga3and5results.hpp"
 #include "../chess/engine/ga1results.hpp"
 #include "../chess/engine/chess.hpp"
@@ -24,8 +28,11 @@
 
 class GA2 {
 public:
-    GA2(size_t populationSize, double initialMutationRate, double mutationDecayRate, double crossoverRate, int totalGenerations, int eliteCount, int archiveSize, int reintroduceCount)
-        : populationSize(populationSize), initialMutationRate(initialMutationRate), mutationDecayRate(mutationDecayRate),  crossoverRate(crossoverRate),totalGenerations(totalGenerations), eliteCount(eliteCount), archiveSize(archiveSize), reintroduceCount(reintroduceCount), book("../openingbook/Titans.bin") {
+    // the same seed replays the same run: population, openings and games (which use fixed node counts, not a clock)
+    GA2(size_t populationSize, double initialMutationRate, double mutationDecayRate, double crossoverRate, int totalGenerations, int eliteCount, int archiveSize, int reintroduceCount, unsigned seed = std::random_device{}())
+        : populationSize(populationSize), initialMutationRate(initialMutationRate), mutationDecayRate(mutationDecayRate),  crossoverRate(crossoverRate),totalGenerations(totalGenerations), eliteCount(eliteCount), archiveSize(archiveSize), reintroduceCount(reintroduceCount), book("../openingbook/Titans.bin"), seed(seed), gen(seed) {
+        Logger::getInstance().log("Seed: " + std::to_string(seed));
+        ::gen.seed(seed); // the random chromosomes come from the generator in ga_util
         initializePopulation();
         
     }
@@ -114,9 +121,26 @@ private:
     PolyglotBook book;
     TunableSearch opponent = baseSearch; // initialize to a value much better than base search
     int opponentCount = 0;
+    Sprt sprt = Sprt(0, 30); // a player replaces the opponent once it is shown to be at least 30 elo better
     std::vector<chromosome> population; // a vector of pairs of chromosomes and their fitness levels
-    std::random_device rd;
-    std::mt19937 gen{rd()}; // random c++ magic stuff
+    unsigned seed;
+    std::mt19937 gen; // random c++ magic stuff, seeded with seed
+    // search limits for every move of a fitness game, 0 for no limit
+    // a node count instead of a time limit keeps games reproducible and independent of how busy the machine is
+    int gameDepth = 0;
+    long gameNodes = 60000; // around the old 60ms per move at 1M nodes per second
+    size_t gameTTEntries = 1 << 18; // plenty for gameNodes, the engine default is far bigger
+
+    // the board and searchers one thread plays its fitness games with
+    struct GameSlot {
+        size_t ttEntries;
+        Board board;
+        Searcher2 white;
+        Searcher2 black;
+
+        GameSlot(size_t ttEntries)
+            : ttEntries(ttEntries), white(board, baseSearch, ga1result10, ttEntries), black(board, baseSearch, ga1result10, ttEntries) {}
+    };
 
 
 
@@ -126,23 +150,27 @@ private:
     }
 
 
+    // play 8 moves into the book, randomly selecting moves
+std::vector<Move> pickOpening(std::mt19937& rng) {
+    std::vector<Move> opening;
+    Board board = Board();
+    Move openingMove = book.pickRandomMove(board, rng);
+    while (openingMove != Move::NULL_MOVE && opening.size() < 8) {
+        board.makeMove(openingMove);
+        opening.push_back(openingMove);
+        openingMove = book.pickRandomMove(board, rng);
+    }
+    return opening;
+}
+
     // Function to simulate a game between two searchers
-int simulateGame(Searcher2& whiteSearcher, Searcher2& blackSearcher, Board& board) {
+int simulateGame(Searcher2& whiteSearcher, Searcher2& blackSearcher, Board& board, const std::vector<Move>& opening) {
     int result = 0;
     int moveCount = 0;
     board.setFen(constants::STARTPOS); // Set the board to the starting position
-    // play 8 moves into the book, randomly selecting moves
-    Move openingMove = book.pickRandomMove(board);
-    while (openingMove != Move::NULL_MOVE && moveCount < 8) {
-        if (openingMove == Move::NULL_MOVE) {
-            std::cerr << "Error: " << "Null Move in opening" << std::endl;
-            std::cerr << "Move: " << openingMove << std::endl;
-            std::cerr << "Fen: " << board.getFen() << std::endl; 
-            break;
-        }
+    for (const Move& openingMove : opening) {
         board.makeMove(openingMove);
         moveCount++;
-        openingMove = book.pickRandomMove(board);
     }
     whiteSearcher.setVerbose(false); // Disable verbose output for white
     blackSearcher.setVerbose(false); // Disable verbose output for black
@@ -151,9 +179,9 @@ int simulateGame(Searcher2& whiteSearcher, Searcher2& blackSearcher, Board& boar
         SearchState searchResult;
 
         if (board.sideToMove() == Color::WHITE) {
-            searchResult = whiteSearcher.iterativeDeepening(60, 0, 1); //1000ms, 0ms increment, 1 move to go
+            searchResult = whiteSearcher.fixedSearch(gameDepth, gameNodes);
         } else {
-            searchResult = blackSearcher.iterativeDeepening(60, 0, 1); // should reach max depth first, but just in case, call cutoff after one fourth of a second in bad circumstances
+            searchResult = blackSearcher.fixedSearch(gameDepth, gameNodes);
         }
         // very aggresive early end to games for the sake of time
         if (searchResult.bestScore < -350){
@@ -198,18 +226,21 @@ int simulateGame(Searcher2& whiteSearcher, Searcher2& blackSearcher, Board& boar
 }
 
     // Example of TunableEval to Searcher conversion not shown, assuming direct use
-double calculateFitnessSingleGame(TunableSearch& params, bool color) {
-    double totalPoints = 0.0;
-    Board board = Board();
-    // Use an if-else statement based on the random boolean
-    if (color) {
-        Searcher2 white = Searcher2(board, params, ga1result10); 
-        Searcher2 black = Searcher2(board, opponent, ga1result10);
-    return simulateGame(white, black, board);
-    } 
-    Searcher2 white = Searcher2(board, opponent, ga1result10); 
-    Searcher2 black = Searcher2(board, params, ga1result10);
-    return -simulateGame(white, black, board); // flip the sign sice the params player is now black
+double calculateFitnessSingleGame(const TunableSearch& params, bool color, const std::vector<Move>& opening) {
+    // every thread keeps one board and two searchers for all the games it plays,
+    // instead of allocating and zeroing two transposition tables per game
+    static thread_local std::unique_ptr<GameSlot> slot;
+    if (!slot || slot->ttEntries != gameTTEntries) {
+        slot = std::make_unique<GameSlot>(gameTTEntries);
+    }
+    Searcher2& player = color ? slot->white : slot->black;
+    Searcher2& other = color ? slot->black : slot->white;
+    player.setSearchParams(params);
+    other.setSearchParams(opponent);
+    slot->white.newGame();
+    slot->black.newGame();
+    int result = simulateGame(slot->white, slot->black, slot->board, opening);
+    return color ? result : -result; // flip the sign sice the params player is now black
 }
 
 
@@ -218,41 +249,53 @@ double calculateFitnessSingleGame(TunableSearch& params, bool color) {
 
 
 void calculateFitness() {
-    std::vector<std::thread> threads;
-    std::vector<double> fitnessScores(populationSize, 0.0); // Initial fitness scores
-    std::mutex updateMutex;
-
-    // Launch a thread for each player in the population
-    for (int i = 0; i < populationSize; i++) {
-        threads.emplace_back([&, i] {
-            double playerScore = 0.0; // Player's total score
-            bool color = true;
-            // Iterate 100 games
-            for (int j = 0; j < 200; j++) {
-                if (j % 2 == 0) {
-                    color = true;
-                } else {
-                    color = false;
-                }
-                // Assuming calculateFitnessForSingleMatch handles a match between two players
-                TunableSearch params = convertChromosomeToSearch(population[i].chromosome);
-                int matchResult = calculateFitnessSingleGame(params, color);
-                std::lock_guard<std::mutex> guard(updateMutex);
-                fitnessScores[i] += (matchResult); 
-            }
-        }); // Pass the current player index to the thread
+    const size_t pairsPerPlayer = 100; // at most 200 games, sprt usually stops long before that
+    // every player gets the same openings, each one played once as white and once as black
+    // they only depend on the seed and the generation, so a generation can be replayed on its own
+    std::mt19937 openingRng(seed + currentGeneration);
+    std::vector<std::vector<Move>> openings;
+    for (size_t j = 0; j < pairsPerPlayer; j++) {
+        openings.push_back(pickOpening(openingRng));
     }
+    std::vector<TunableSearch> players;
+    for (const chromosome& individual : population) {
+        players.push_back(convertChromosomeToSearch(individual.chromosome));
+    }
+    // result of every pair (net result + 3, 0 while it hasn't been played), slot i * pairsPerPlayer + j
+    std::vector<std::atomic<int>> pairResults(populationSize * pairsPerPlayer);
+    std::vector<std::atomic<bool>> stopped(populationSize); // set once the test has decided on a player
+
+    // every game pair is its own task, so the pool stays busy until the last game of the generation
+    // the tasks go round robin over the players, so they all get their first pairs in early
+    // and the pairs left over for players that are already decided are skipped
+    ThreadPool::global().parallelFor(0, populationSize * pairsPerPlayer, 1, [&](size_t task) {
+        const size_t i = task % populationSize;
+        const size_t j = task / populationSize;
+        if (stopped[i].load(std::memory_order_relaxed)) {
+            return;
+        }
+        int pairResult = static_cast<int>(calculateFitnessSingleGame(players[i], true, openings[j]) + calculateFitnessSingleGame(players[i], false, openings[j]));
+        pairResults[i * pairsPerPlayer + j].store(pairResult + 3);
 
-    // Wait for all threads to complete
-    for (auto& thread : threads) {
-        if (thread.joinable()) {
-            thread.join();
+        Sprt::Pentanomial counts;
+        if (sequentialTest(&pairResults[i * pairsPerPlayer], pairsPerPlayer, counts) != Sprt::NONE) {
+            stopped[i].store(true, std::memory_order_relaxed);
         }
-    }
+    });
+
+    int stoppedEarly = 0;
+    size_t gamesPlayed = 0;
     int maxFitness = population.front().fitness;
     for (size_t i = 0; i < populationSize; ++i) {
-        population[i].fitness = fitnessScores[i];
-        if (population[i].fitness >= 43 && population[i].fitness > maxFitness) {  // if we are net +43, we're 99.99% sure we're better
+        for (size_t j = 0; j < pairsPerPlayer; j++) {
+            gamesPlayed += pairResults[i * pairsPerPlayer + j].load() != 0 ? 2 : 0;
+        }
+        Sprt::Pentanomial counts;
+        Sprt::Decision decision = sequentialTest(&pairResults[i * pairsPerPlayer], pairsPerPlayer, counts);
+        int pairs = Sprt::pairs(counts);
+        stoppedEarly += decision != Sprt::NONE;
+        population[i].fitness = pairs == 0 ? 0.0 : static_cast<double>(Sprt::netResult(counts)) * pairsPerPlayer / pairs;
+        if (decision == Sprt::H1 && population[i].fitness > maxFitness) {
             maxFitness = population[i].fitness;
             opponentCount ++;
             opponent = convertChromosomeToSearch(population[i].chromosome);     
@@ -262,6 +305,26 @@ void calculateFitness() {
         }
         population[i].opponent = opponentCount;
     }
+    Logger::getInstance().log("SPRT: " + std::to_string(stoppedEarly) + " players stopped early, " + std::to_string(gamesPlayed) + " of " + std::to_string(2 * pairsPerPlayer * populationSize) + " games played");
+}
+
+// runs the test over one player's pairs in opening order, up to the first pair that isn't finished
+// other threads may finish pairs in any order, but going in order means a player always stops
+// at the same pair for the same results, so the fitness doesn't depend on thread timing
+Sprt::Decision sequentialTest(const std::atomic<int>* results, size_t pairs, Sprt::Pentanomial& counts) const {
+    counts = {};
+    for (size_t j = 0; j < pairs; j++) {
+        int result = results[j].load();
+        if (result == 0) {
+            break;
+        }
+        counts[result - 1]++;
+        Sprt::Decision decision = sprt.decide(counts);
+        if (decision != Sprt::NONE) {
+            return decision;
+        }
+    }
+    return Sprt::NONE;
 }
 
 
@@ -224,6 +224,18 @@ TunableSearch convertChromosomeToSearch(const std::string& bitString){
     pos += 3;
     tSearch.nullMovePruningDepthFactor = bitsToInt(bitString.substr(pos, 5));
     pos += 5;
+    tSearch.iirDepth = bitsToInt(bitString.substr(pos, 3));
+    pos += 3;
+    tSearch.iidDepth = bitsToInt(bitString.substr(pos, 3));
+    pos += 3;
+    tSearch.iidReduction = bitsToInt(bitString.substr(pos, 2));
+    pos += 2;
+    tSearch.probCutMargin = bitsToInt(bitString.substr(pos, 8));
+    pos += 8;
+    tSearch.probCutDepth = bitsToInt(bitString.substr(pos, 3));
+    pos += 3;
+    tSearch.probCutReduction = bitsToInt(bitString.substr(pos, 3));
+    pos += 3;
 
     return tSearch;
 }
@@ -247,6 +259,12 @@ std::string convertSearchToChromosome(const TunableSearch& tSearch){
     bitString += intToGrayString(tSearch.lmpMoveCount, 4);
     bitString += intToGrayString(tSearch.nullMovePruningInitialReduction, 3);
     bitString += intToGrayString(tSearch.nullMovePruningDepthFactor, 5);
+    bitString += intToGrayString(tSearch.iirDepth, 3);
+    bitString += intToGrayString(tSearch.iidDepth, 3);
+    bitString += intToGrayString(tSearch.iidReduction, 2);
+    bitString += intToGrayString(tSearch.probCutMargin, 8);
+    bitString += intToGrayString(tSearch.probCutDepth, 3);
+    bitString += intToGrayString(tSearch.probCutReduction, 3);
     
     return bitString;
 
@@ -266,6 +284,12 @@ TunableSearch initializeRandomTunableSearch() {
     rSearch.lmpMoveCount = randomInt(4);
     rSearch.nullMovePruningInitialReduction = randomInt(3);
     rSearch.nullMovePruningDepthFactor = randomInt(5);
+    rSearch.iirDepth = randomInt(3);
+    rSearch.iidDepth = randomInt(3);
+    rSearch.iidReduction = randomInt(2);
+    rSearch.probCutMargin = randomInt(8);
+    rSearch.probCutDepth = randomInt(3);
+    rSearch.probCutReduction = randomInt(3);
     return rSearch;
 }
 
@@ -451,6 +475,12 @@ void printTunableSearch(const TunableSearch& tSearch){
     logMsg << tSearch.lmpMoveCount << ", // LMP Move Count\n";
     logMsg << tSearch.nullMovePruningInitialReduction << ", // Null Move Pruning Initial Reduction\n";
     logMsg << tSearch.nullMovePruningDepthFactor << ", // Null Move Pruning Depth Factor\n";
+    logMsg << tSearch.iirDepth << ", // IIR Depth\n";
+    logMsg << tSearch.iidDepth << ", // IID Depth\n";
+    logMsg << tSearch.iidReduction << ", // IID Reduction\n";
+    logMsg << tSearch.probCutMargin << ", // ProbCut Margin\n";
+    logMsg << tSearch.probCutDepth << ", // ProbCut Depth\n";
+    logMsg << tSearch.probCutReduction << ", // ProbCut Reduction\n";
     logMsg << "};\n";
     Logger::getInstance().log(logMsg.str());
     std::cout << logMsg.str();
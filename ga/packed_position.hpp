@@ -0,0 +1,81 @@
+// training positions packed into 32 bytes, so a training set can be parsed from fens once
+// and then kept in one contiguous buffer instead of a string per position
+// the layout is the occupancy bitboard plus a 4 bit piece code for each occupied square
+// (in square order), which fits any legal position since there are never more than 32 pieces
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "../chess/engine/chess.hpp"
+
+using namespace chess;
+
+struct PackedPosition {
+    uint64_t occupancy = 0;
+    uint8_t pieces[16] = {}; // two pieces per byte, low nibble first
+    uint8_t sideToMove = 0;
+    uint8_t castling = 0; // KQkq in the low 4 bits, standard chess only
+    uint8_t enpassant = 64; // 64 for none
+    uint8_t halfMoves = 0;
+    uint8_t padding[4] = {};
+
+    static PackedPosition pack(const Board& board) {
+        PackedPosition p;
+        p.occupancy = board.occ();
+        if (builtin::popcount(p.occupancy) > 32) {
+            throw std::invalid_argument("more than 32 pieces: " + board.getFen());
+        }
+
+        Bitboard occ = p.occupancy;
+        for (int i = 0; occ; i++) {
+            const uint8_t piece = static_cast<uint8_t>(board.at(builtin::poplsb(occ)));
+            p.pieces[i / 2] |= piece << (4 * (i % 2));
+        }
+
+        const auto rights = board.castlingRights();
+        p.sideToMove = board.sideToMove() == Color::WHITE ? 0 : 1;
+        p.castling = rights.hasCastlingRight(Color::WHITE, CastleSide::KING_SIDE)
+            | rights.hasCastlingRight(Color::WHITE, CastleSide::QUEEN_SIDE) << 1
+            | rights.hasCastlingRight(Color::BLACK, CastleSide::KING_SIDE) << 2
+            | rights.hasCastlingRight(Color::BLACK, CastleSide::QUEEN_SIDE) << 3;
+        p.enpassant = board.enpassantSq() == Square::NO_SQ ? 64 : static_cast<uint8_t>(board.enpassantSq());
+        p.halfMoves = static_cast<uint8_t>(std::min<uint32_t>(board.halfMoveClock(), 255));
+        return p;
+    }
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition should stay 32 bytes");
+
+// a Board that can be set up straight from a PackedPosition, without going through a fen
+class PackedBoard : public Board {
+public:
+    void unpack(const PackedPosition& p) {
+        std::fill(std::begin(board_), std::end(board_), Piece::NONE);
+        for (int c = 0; c < 2; c++) {
+            for (int pt = 0; pt < 6; pt++) {
+                pieces_bb_[c][pt] = 0ULL;
+            }
+        }
+        occ_all_ = 0ULL;
+        material_key_ = 0ULL;
+
+        Bitboard occ = p.occupancy;
+        for (int i = 0; occ; i++) {
+            const Piece piece = static_cast<Piece>((p.pieces[i / 2] >> (4 * (i % 2))) & 0xF);
+            placePiece(piece, builtin::poplsb(occ));
+        }
+
+        side_to_move_ = p.sideToMove ? Color::BLACK : Color::WHITE;
+        castling_rights_.clearAllCastlingRights();
+        if (p.castling & 1) castling_rights_.setCastlingRight(Color::WHITE, CastleSide::KING_SIDE, File::FILE_H);
+        if (p.castling & 2) castling_rights_.setCastlingRight(Color::WHITE, CastleSide::QUEEN_SIDE, File::FILE_A);
+        if (p.castling & 4) castling_rights_.setCastlingRight(Color::BLACK, CastleSide::KING_SIDE, File::FILE_H);
+        if (p.castling & 8) castling_rights_.setCastlingRight(Color::BLACK, CastleSide::QUEEN_SIDE, File::FILE_A);
+        enpassant_sq_ = p.enpassant == 64 ? Square::NO_SQ : Square(p.enpassant);
+        half_moves_ = p.halfMoves;
+        plies_played_ = 0;
+
+        hash_key_ = zobrist();
+        prev_states_.clear();
+    }
+};
@@ -38,6 +38,12 @@ int main() {
     assert(randomSearch.lmpMoveCount == randomSearchClone.lmpMoveCount);
     assert(randomSearch.nullMovePruningInitialReduction == randomSearchClone.nullMovePruningInitialReduction);
     assert(randomSearch.nullMovePruningDepthFactor == randomSearchClone.nullMovePruningDepthFactor);
+    assert(randomSearch.iirDepth == randomSearchClone.iirDepth);
+    assert(randomSearch.iidDepth == randomSearchClone.iidDepth);
+    assert(randomSearch.iidReduction == randomSearchClone.iidReduction);
+    assert(randomSearch.probCutMargin == randomSearchClone.probCutMargin);
+    assert(randomSearch.probCutDepth == randomSearchClone.probCutDepth);
+    assert(randomSearch.probCutReduction == randomSearchClone.probCutReduction);
 
     double initialMutationRate = 0.05;
     double decayRate = 0;
@@ -0,0 +1,60 @@
+#include "texel.hpp"
+#include <string>
+#include <chrono>
+#include <sstream>
+
+// tunes TunableEval with gradients instead of the ga
+// usage: ./runTexel [training data (.csv or .bin from extractFeatures)] [output header]
+int main(int argc, char** argv) {
+    std::string trainingDataPath = argc > 1 ? argv[1] : "../dbs/data_files/stockfish11.csv";
+    std::string outputPath = argc > 2 ? argv[2] : "texel_results.hpp";
+    bool resultLabels = false; // the csvs in dbs/data_files hold centipawn evals, not game results
+    int epochs = 1000;
+    double learningRate = 1.0;
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    FeatureMatrix data;
+    if (trainingDataPath.size() > 4 && trainingDataPath.substr(trainingDataPath.size() - 4) == ".bin") {
+        data.load(trainingDataPath);
+    }
+    else {
+        data.addCSV(trainingDataPath);
+    }
+    if (data.empty()) {
+        std::cout << "No training positions in " << trainingDataPath << std::endl;
+        return 1;
+    }
+
+    std::cout << "Running Texel Tuner" << std::endl;
+    std::cout << "Training Data Path: " << trainingDataPath << std::endl;
+    std::cout << "Positions: " << data.size() << std::endl;
+    std::cout << "Epochs: " << epochs << std::endl;
+    std::cout << "Learning Rate: " << learningRate << std::endl;
+
+    TexelTuner tuner(data, resultLabels);
+    if (resultLabels) {
+        std::cout << "Scale: " << tuner.fitScale() << std::endl;
+    }
+    std::cout << "Baseline Loss: " << tuner.loss() << std::endl;
+    std::cout << "Baseline Fitness: " << data.meanAbsoluteError(baseEval) << std::endl;
+
+    double finalLoss = tuner.tune(epochs, learningRate);
+    TunableEval tuned = tuner.result();
+    std::cout << "Final Loss: " << finalLoss << std::endl;
+    std::cout << "Final Fitness: " << data.meanAbsoluteError(tuned) << std::endl;
+
+    std::ostringstream comment;
+    comment << "Texel Tuner\n";
+    comment << "Epochs: " << epochs << "\n";
+    comment << "Learning Rate: " << learningRate << "\n";
+    comment << "Scale: " << tuner.getScale() << "\n";
+    comment << "Final Loss: " << finalLoss << "\n";
+    comment << "Training Data Path: " << trainingDataPath << "\n";
+    tuner.writeHeader(outputPath, "texelResult", comment.str());
+    std::cout << "Wrote " << outputPath << std::endl;
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "Time taken: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " ms" << std::endl;
+    return 0;
+}
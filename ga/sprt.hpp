@@ -0,0 +1,98 @@
+// sequential probability ratio test for ga2 matches, so a player can stop playing
+// as soon as it is clearly worse (or clearly better) than the opponent
+// games are counted in pairs, the same opening once with each color, and a pair's net result
+// (-2 to 2 from the player's side) is put in one of five buckets (the pentanomial model)
+// pairing cancels out most of the luck of getting a lopsided opening, so decisions come sooner
+// the log likelihood ratio uses the usual normal approximation (same as fishtest):
+// llr = pairs * (s1 - s0) * (2 * mean - s0 - s1) / (2 * variance)
+// where s0 and s1 are the expected scores at elo0 and elo1, and mean/variance are of the pair scores
+#pragma once
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+class Sprt {
+public:
+    enum Decision {
+        NONE, // keep playing
+        H0, // not better than elo0
+        H1 // at least elo1 better
+    };
+
+    // pair counts indexed by net result + 2, so counts[0] is two losses and counts[4] two wins
+    using Pentanomial = std::array<int, 5>;
+
+    Sprt(double elo0, double elo1, double alpha = 0.05, double beta = 0.05, int minPairs = 5)
+        : elo0(elo0), elo1(elo1), minPairs(minPairs) {
+        lower = std::log(beta / (1 - alpha));
+        upper = std::log((1 - beta) / alpha);
+    }
+
+    static int pairs(const Pentanomial& counts) {
+        return counts[0] + counts[1] + counts[2] + counts[3] + counts[4];
+    }
+
+    // sum of the game results, a win being +1 and a loss -1
+    static int netResult(const Pentanomial& counts) {
+        int net = 0;
+        for (int k = 0; k < 5; k++) {
+            net += (k - 2) * counts[k];
+        }
+        return net;
+    }
+
+    double llr(const Pentanomial& counts) const {
+        const int n = pairs(counts);
+        if (n == 0) {
+            return 0.0;
+        }
+        double mean = 0.0;
+        for (int k = 0; k < 5; k++) {
+            mean += counts[k] * (k / 4.0);
+        }
+        mean /= n;
+        double variance = 0.0;
+        for (int k = 0; k < 5; k++) {
+            variance += counts[k] * (k / 4.0 - mean) * (k / 4.0 - mean);
+        }
+        // all pairs ending the same way would give a variance of 0, floor it so the ratio stays finite
+        variance = std::max(variance / n, 1e-3);
+
+        const double s0 = expectedScore(elo0);
+        const double s1 = expectedScore(elo1);
+        return n * (s1 - s0) * (2 * mean - s0 - s1) / (2 * variance);
+    }
+
+    Decision decide(const Pentanomial& counts) const {
+        if (pairs(counts) < minPairs) {
+            return NONE;
+        }
+        const double ratio = llr(counts);
+        if (ratio <= lower) {
+            return H0;
+        }
+        if (ratio >= upper) {
+            return H1;
+        }
+        return NONE;
+    }
+
+    double lowerBound() const {
+        return lower;
+    }
+
+    double upperBound() const {
+        return upper;
+    }
+
+private:
+    double elo0;
+    double elo1;
+    int minPairs; // don't trust the variance estimate before this many pairs
+    double lower;
+    double upper;
+
+    static double expectedScore(double elo) {
+        return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+    }
+};
@@ -0,0 +1,224 @@
+// texel style tuning of TunableEval, the gradient based alternative to ga1
+// the eval is turned into a win probability with a sigmoid, and we minimize the cross entropy
+// against the training labels (game results, or centipawn evals squashed by the same sigmoid)
+// since the eval is linear in the weights (see EvalFeatures), the gradient is exact and cheap:
+// d eval / d mg = count * phase and d eval / d eg = count * (1 - phase)
+// the weights are updated with Adam, and each gradient pass is split over the thread pool
+#pragma once
+#include <vector>
+#include <string>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include "feature_matrix.hpp"
+#include "thread_pool.hpp"
+#include "../chess/engine/baselines.hpp"
+
+struct TexelField {
+    GamePhaseValue TunableEval::* weight;
+    const char* name;
+};
+
+// every TunableEval weight in declaration order, the order a TunableEval initializer list needs
+static const TexelField TEXEL_FIELDS[] = {
+    {&TunableEval::pawn, "Pawn"},
+    {&TunableEval::knight, "Knight"},
+    {&TunableEval::bishop, "Bishop"},
+    {&TunableEval::rook, "Rook"},
+    {&TunableEval::queen, "Queen"},
+    {&TunableEval::passedPawn, "Passed Pawn"},
+    {&TunableEval::doubledPawn, "Doubled Pawn"},
+    {&TunableEval::isolatedPawn, "Isolated Pawn"},
+    {&TunableEval::weakPawn, "Weak Pawn"},
+    {&TunableEval::centralPawn, "Central Pawn"},
+    {&TunableEval::weakSquare, "Weak Square"},
+    {&TunableEval::passedPawnEnemyKingSquare, "Passed Pawn Enemy King Square"},
+    {&TunableEval::knightOutposts, "Knight Outposts"},
+    {&TunableEval::knightMobility, "Knight Mobility"},
+    {&TunableEval::bishopMobility, "Bishop Mobility"},
+    {&TunableEval::bishopPair, "Bishop Pair"},
+    {&TunableEval::rookAttackKingFile, "Rook Attack King File"},
+    {&TunableEval::rookAttackKingAdjFile, "Rook Attack King Adjacent File"},
+    {&TunableEval::rook7thRank, "Rook 7th Rank"},
+    {&TunableEval::rookConnected, "Rook Connected"},
+    {&TunableEval::rookMobility, "Rook Mobility"},
+    {&TunableEval::rookBehindPassedPawn, "Rook Behind Passed Pawn"},
+    {&TunableEval::rookOpenFile, "Rook Open File"},
+    {&TunableEval::rookSemiOpenFile, "Rook Semi Open File"},
+    {&TunableEval::rookAtckWeakPawnOpenColumn, "Rook Attack Weak Pawn Open Column"},
+    {&TunableEval::queenMobility, "Queen Mobility"},
+    {&TunableEval::kingFriendlyPawn, "King Friendly Pawn"},
+    {&TunableEval::kingNoEnemyPawnNear, "King No Enemy Pawn Near"},
+    {&TunableEval::kingPressureScore, "King Pressure Score"},
+};
+
+class TexelTuner {
+public:
+    static const int FIELDS = sizeof(TEXEL_FIELDS) / sizeof(TEXEL_FIELDS[0]);
+    static const int PARAMS = 2 * FIELDS; // mg and eg of each field
+
+    // resultLabels: targets are game results from white's side (1, 0.5, 0) instead of centipawns
+    TexelTuner(const FeatureMatrix& data, bool resultLabels, const TunableEval& start = baseEval)
+        : data(data), resultLabels(resultLabels) {
+        for (int c = 0; c < FeatureMatrix::COLUMNS; c++) {
+            GamePhaseValue TunableEval::* weight = c < EvalFeatures::MATERIAL
+                ? MATERIAL_WEIGHTS[c]
+                : TERM_WEIGHTS[c - EvalFeatures::MATERIAL];
+            for (int f = 0; f < FIELDS; f++) {
+                if (TEXEL_FIELDS[f].weight == weight) {
+                    columnField[c] = f;
+                }
+            }
+        }
+        for (int f = 0; f < FIELDS; f++) {
+            params[2 * f] = (start.*TEXEL_FIELDS[f].weight).middleGame;
+            params[2 * f + 1] = (start.*TEXEL_FIELDS[f].weight).endGame;
+        }
+        numThreads = static_cast<unsigned>(pool.size());
+    }
+
+    // the classic texel first step: find the sigmoid scale that fits the starting weights best
+    // only makes sense for game results, centipawn labels go through the same sigmoid anyway
+    double fitScale() {
+        double lo = 0.1, hi = 3.0;
+        for (int i = 0; i < 40; i++) {
+            double a = lo + (hi - lo) / 3, b = hi - (hi - lo) / 3;
+            scale = a;
+            double lossA = loss();
+            scale = b;
+            double lossB = loss();
+            if (lossA < lossB) {
+                hi = b;
+            }
+            else {
+                lo = a;
+            }
+        }
+        scale = (lo + hi) / 2;
+        return scale;
+    }
+
+    double loss() {
+        double gradient[PARAMS];
+        return lossAndGradient(gradient, false);
+    }
+
+    // full batch Adam, returns the final loss
+    // the pawn middlegame value stays fixed at 100 so the weights stay in centipawns
+    double tune(int epochs, double learningRate, bool verbose = true) {
+        const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+        double m[PARAMS] = {}, v[PARAMS] = {};
+        double gradient[PARAMS];
+        params[0] = 100;
+
+        double currentLoss = 0;
+        for (int epoch = 1; epoch <= epochs; epoch++) {
+            currentLoss = lossAndGradient(gradient, true);
+            gradient[0] = 0;
+            for (int i = 0; i < PARAMS; i++) {
+                m[i] = beta1 * m[i] + (1 - beta1) * gradient[i];
+                v[i] = beta2 * v[i] + (1 - beta2) * gradient[i] * gradient[i];
+                double mHat = m[i] / (1 - std::pow(beta1, epoch));
+                double vHat = v[i] / (1 - std::pow(beta2, epoch));
+                params[i] -= learningRate * mHat / (std::sqrt(vHat) + epsilon);
+            }
+            if (verbose && (epoch % 100 == 0 || epoch == 1)) {
+                std::cout << "Epoch: " << epoch << " Loss: " << currentLoss << std::endl;
+            }
+        }
+        return currentLoss;
+    }
+
+    TunableEval result() const {
+        TunableEval tuned = baseEval;
+        for (int f = 0; f < FIELDS; f++) {
+            tuned.*TEXEL_FIELDS[f].weight = GamePhaseValue(static_cast<int>(std::lround(params[2 * f])), static_cast<int>(std::lround(params[2 * f + 1])));
+        }
+        return tuned;
+    }
+
+    // writes the result as a header like ga1results.hpp
+    void writeHeader(const std::string& filename, const std::string& name, const std::string& comment) const {
+        TunableEval tuned = result();
+        std::ofstream out(filename);
+        out << "#pragma once\n";
+        out << "#include \"baselines.hpp\"\n";
+        out << "#include \"chess.hpp\"\n\n";
+        out << "/*\n" << comment << "*/\n";
+        out << "TunableEval " << name << " = {\n";
+        out << "    chess::constants::STARTPOS,\n";
+        for (int f = 0; f < FIELDS; f++) {
+            const GamePhaseValue& weight = tuned.*TEXEL_FIELDS[f].weight;
+            out << "    GamePhaseValue(" << weight.middleGame << ", " << weight.endGame << "), // " << TEXEL_FIELDS[f].name << "\n";
+        }
+        out << "};\n";
+    }
+
+    double getScale() const {
+        return scale;
+    }
+
+private:
+    const FeatureMatrix& data;
+    bool resultLabels;
+    double scale = 1.0; // multiplies the usual 400 centipawns per factor of 10 in odds
+    double params[PARAMS];
+    int columnField[FeatureMatrix::COLUMNS];
+    ThreadPool& pool = ThreadPool::global();
+    unsigned numThreads; // one slice of the rows per pool thread
+
+    double sigmoid(double eval) const {
+        return 1.0 / (1.0 + std::exp(-scale * eval * std::log(10.0) / 400.0));
+    }
+
+    // mean cross entropy over all rows, and its gradient with respect to params if wanted
+    double lossAndGradient(double gradient[PARAMS], bool wantGradient) {
+        float mgWeights[FeatureMatrix::COLUMNS];
+        float egWeights[FeatureMatrix::COLUMNS];
+        for (int c = 0; c < FeatureMatrix::COLUMNS; c++) {
+            mgWeights[c] = params[2 * columnField[c]];
+            egWeights[c] = params[2 * columnField[c] + 1];
+        }
+
+        std::vector<std::vector<double>> partialGradients(numThreads, std::vector<double>(PARAMS, 0.0));
+        std::vector<double> partialLosses(numThreads, 0.0);
+        const size_t rows = data.size();
+        const double k = scale * std::log(10.0) / 400.0;
+
+        pool.parallelFor(0, numThreads, 1, [&](size_t t) {
+            std::vector<double>& g = partialGradients[t];
+            double lossSum = 0;
+            for (size_t r = t * rows / numThreads; r < (t + 1) * rows / numThreads; r++) {
+                const double phase = data.phase(r);
+                const double endgameScale = data.scale(r);
+                const double p = sigmoid(data.evaluate(r, mgWeights, egWeights));
+                const double y = resultLabels ? data.target(r) : sigmoid(data.target(r));
+                const double pc = std::min(std::max(p, 1e-12), 1 - 1e-12);
+                lossSum -= y * std::log(pc) + (1 - y) * std::log(1 - pc);
+                if (!wantGradient) {
+                    continue;
+                }
+                // d loss / d eval of the sigmoid cross entropy
+                const double d = (p - y) * k;
+                data.forEachFeature(r, [&](int column, int count) {
+                    g[2 * columnField[column]] += d * endgameScale * count * phase;
+                    g[2 * columnField[column] + 1] += d * endgameScale * count * (1 - phase);
+                });
+            }
+            partialLosses[t] = lossSum;
+        });
+
+        double totalLoss = 0;
+        for (int i = 0; i < PARAMS; i++) {
+            gradient[i] = 0;
+        }
+        for (unsigned t = 0; t < numThreads; t++) {
+            totalLoss += partialLosses[t];
+            for (int i = 0; i < PARAMS; i++) {
+                gradient[i] += partialGradients[t][i] / rows;
+            }
+        }
+        return totalLoss / rows;
+    }
+};
@@ -0,0 +1,218 @@
+// a thread pool that lives for the whole run, so the gas don't start fresh threads for every fitness call
+// each worker has its own task queue: it takes its newest task first, and when it runs dry it steals
+// the oldest task of another worker, which keeps everyone busy when some tasks (games) run much
+// longer than others. Threads that wait for a parallelFor help out instead of sleeping
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+class ThreadPool {
+public:
+    // 0 threads means one per core, and there is always at least one
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        threads = std::max(1u, threads);
+        for (unsigned i = 0; i < threads; i++) {
+            queues.push_back(std::make_unique<TaskQueue>());
+        }
+        for (unsigned i = 0; i < threads; i++) {
+            workers.emplace_back([this, i]() { workerLoop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        sleepCv.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    // runs task on some worker, wait() blocks until every submitted task is done
+    void submit(std::function<void()> task) {
+        unfinished.fetch_add(1);
+        push([this, task = std::move(task)]() {
+            task();
+            if (unfinished.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                doneCv.notify_all();
+            }
+        });
+    }
+
+    void wait() {
+        helpUntil([this]() { return unfinished.load() == 0; });
+    }
+
+    // calls f(i) for every i in [begin, end), in chunks of chunkSize indices per task
+    template <typename F>
+    void parallelFor(size_t begin, size_t end, size_t chunkSize, F&& f) {
+        if (begin >= end) {
+            return;
+        }
+        chunkSize = std::max<size_t>(1, chunkSize);
+        const size_t chunks = (end - begin + chunkSize - 1) / chunkSize;
+        std::atomic<size_t> remaining{chunks};
+
+        for (size_t c = 0; c < chunks; c++) {
+            const size_t from = begin + c * chunkSize;
+            const size_t to = std::min(end, from + chunkSize);
+            push([this, from, to, &f, &remaining]() {
+                for (size_t i = from; i < to; i++) {
+                    f(i);
+                }
+                if (remaining.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(sleepMutex);
+                    doneCv.notify_all();
+                }
+            });
+        }
+        helpUntil([&remaining]() { return remaining.load() == 0; });
+    }
+
+    // combine(map(begin), map(begin + 1), ...) starting from init, with one partial result per chunk
+    // combine has to be associative, the partial results are combined in chunk order
+    template <typename T, typename Map, typename Combine>
+    T parallelReduce(size_t begin, size_t end, size_t chunkSize, T init, Map&& map, Combine&& combine) {
+        if (begin >= end) {
+            return init;
+        }
+        chunkSize = std::max<size_t>(1, chunkSize);
+        const size_t chunks = (end - begin + chunkSize - 1) / chunkSize;
+        std::vector<T> partials(chunks, init);
+
+        parallelFor(0, chunks, 1, [&](size_t c) {
+            const size_t from = begin + c * chunkSize;
+            const size_t to = std::min(end, from + chunkSize);
+            T partial = map(from);
+            for (size_t i = from + 1; i < to; i++) {
+                partial = combine(partial, map(i));
+            }
+            partials[c] = partial;
+        });
+
+        T result = init;
+        for (const T& partial : partials) {
+            result = combine(result, partial);
+        }
+        return result;
+    }
+
+    // one pool for the whole program
+    static ThreadPool& global() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0}; // tasks sitting in some queue
+    std::atomic<size_t> unfinished{0}; // submitted tasks not done yet
+    std::atomic<size_t> nextQueue{0};
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv; // workers wait here for tasks
+    std::condition_variable doneCv; // waiting callers wait here for their tasks to finish
+    bool stopping = false;
+
+    static size_t& currentWorker() {
+        static thread_local size_t index = SIZE_MAX;
+        return index;
+    }
+
+    void push(std::function<void()> task) {
+        // a worker keeps the tasks it creates, everyone else spreads them round robin
+        size_t q = currentWorker();
+        if (q >= queues.size()) {
+            q = nextQueue.fetch_add(1) % queues.size();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queues[q]->mutex);
+            queues[q]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            queued.fetch_add(1);
+        }
+        sleepCv.notify_one();
+    }
+
+    // newest task of our own queue, or the oldest of someone else's
+    bool tryRunOne(size_t self) {
+        std::function<void()> task;
+        const size_t n = queues.size();
+        for (size_t k = 0; k < n && !task; k++) {
+            TaskQueue& queue = *queues[(self + k) % n];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (k == 0 && self < n) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+        if (!task) {
+            return false;
+        }
+        queued.fetch_sub(1);
+        task();
+        return true;
+    }
+
+    void workerLoop(size_t index) {
+        currentWorker() = index;
+        while (true) {
+            if (tryRunOne(index)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCv.wait(lock, [this]() { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    template <typename Done>
+    void helpUntil(Done&& done) {
+        const size_t self = currentWorker() < queues.size() ? currentWorker() : nextQueue.load() % queues.size();
+        while (!done()) {
+            if (tryRunOne(self)) {
+                continue;
+            }
+            // nothing left to steal, the last tasks are running elsewhere
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            doneCv.wait(lock, [&]() { return done() || queued.load() > 0; });
+        }
+    }
+};